@@ -2,89 +2,784 @@
 #define BPT_MEMORYRIVER_HPP
 
 #include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "journal.h"
 
 using std::string;
 using std::fstream;
 using std::ifstream;
 using std::ofstream;
 
-template<class T, int info_len = 2>
-class MemoryRiver {
+//页缓存的块大小（字节）与默认容量（块数）
+const int kRiverPageSize = 4096;
+const int kRiverDefaultCachePages = 256;
+//映射模式下映射区按此粒度（字节）增长
+const long kRiverMapChunk = 1L << 20;
+//顺序扫描时每次读入的字节数
+const int kRiverScanBytes = 64 * 1024;
+//索引文件重建完成后写入文件头的标记（"INDX"）；没有标记的索引文件视为不完整
+const int kIndexComplete = 0x58444E49;
+
+//Cached：fstream + 页缓存；Mapped：mmap 整个文件，读写即内存拷贝。
+//映射失败（打开、扩大映射区或扩展文件出错）时自动退回 Cached 模式继续读写同一文件
+enum class RiverMode { Cached, Mapped };
+
+//free_slot > 0 时启用空间回收：第 free_slot 个 info（1_base）存空闲链表表头，
+//被删除的槽位清零，末尾的 int 存下一个空闲槽位的位置索引（0 表示链表结束）
+//挂接 Journal 后，事务期间的修改先暂存在内存中，提交时经日志统一落盘
+template<class T, int info_len = 2, int free_slot = 0>
+class MemoryRiver : public JournalFile {
+  static_assert(free_slot >= 0 && free_slot <= info_len, "free_slot must name an info field");
+  static_assert(free_slot == 0 || sizeof(T) > sizeof(int), "T too small to hold a free-list link");
+
 private:
-  /* your code here */
+  //缓存中的一个块：对应文件中 [block * kRiverPageSize, (block + 1) * kRiverPageSize)
+  struct Page {
+    int block;
+    bool dirty;
+    std::vector<char> data;
+  };
+
   fstream file;
   string file_name;
   int sizeofT = sizeof(T);
+  long file_end = 0;  //逻辑文件长度（含尚未写回的脏块）
+  RiverMode mode = RiverMode::Cached;
+
+  //映射模式：文件长度始终等于 file_end，映射区长度 map_cap 按块预留
+  int fd = -1;
+  char *map_base = nullptr;
+  long map_cap = 0;
+
+  int cache_pages = kRiverDefaultCachePages;
+  std::list<Page> pages;  //表头为最近使用的块
+  std::unordered_map<int, typename std::list<Page>::iterator> page_index;
+  long long hits = 0;
+  long long misses = 0;
+
+  int free_cnt = -1;  //空闲槽位数，-1 表示尚未统计
+
+  //文件头缓存：首次访问时读入，之后 get_info 直接读内存。
+  //事务外的修改在 flush 时写回，事务中的修改在提交时排在数据之后写入
+  int info[info_len > 0 ? info_len : 1];
+  bool info_loaded = false;
+  bool info_dirty = false;    //事务外修改过，尚未写回
+  bool info_pending = false;  //当前事务中修改过
+
+  //事务期间暂存的修改，按发生顺序排列；size < 0 表示写入，否则表示截短到 size
+  struct PendingOp {
+    long pos;
+    long size;
+    string bytes;
+  };
+  Journal *journal = nullptr;
+  std::vector<PendingOp> pending;
+  long txn_end = 0;  //计入暂存修改后的逻辑文件长度
+  static const long kJournalGap = 32;  //相隔不足这么多字节的两段变化合成一条日志项
+
+  bool in_txn() const { return journal != nullptr && journal->active(); }
+
+  long end() const { return pending.empty() ? file_end : txn_end; }
+
+  //文件句柄在对象生命周期内保持打开，首次访问时才真正打开
+  void ensure_open() {
+    if (mode == RiverMode::Mapped) {
+      if (fd < 0) open_mapped();
+      return;
+    }
+    if (file.is_open()) return;
+    file.open(file_name, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+      file.clear();
+      file.open(file_name, std::ios::out | std::ios::binary);
+      file.close();
+      file.open(file_name, std::ios::in | std::ios::out | std::ios::binary);
+    }
+    file.clear();
+    file.seekg(0, std::ios::end);
+    file_end = static_cast<long>(file.tellg());
+    if (file_end < 0) file_end = 0;
+  }
+
+  void open_mapped() {
+    fd = ::open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+      fall_back();
+      return;
+    }
+    file_end = static_cast<long>(st.st_size);
+    if (!remap(file_end)) fall_back();
+  }
+
+  //之前经映射写入的内容已在文件中，换成 fstream 后照常读写
+  void fall_back() {
+    close_mapped();
+    mode = RiverMode::Cached;
+    ensure_open();
+  }
+
+  //保证映射区至少覆盖 need 字节，按 kRiverMapChunk 的倍数成倍扩大；失败时返回 false
+  bool remap(long need) {
+    if (map_base != nullptr && need <= map_cap) return true;
+    long cap = map_cap * 2;
+    if (cap < need) cap = need;
+    cap = (cap + kRiverMapChunk - 1) / kRiverMapChunk * kRiverMapChunk;
+    if (cap == 0) cap = kRiverMapChunk;
+    if (map_base != nullptr) ::munmap(map_base, map_cap);
+    void *p = ::mmap(nullptr, cap, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    map_base = p == MAP_FAILED ? nullptr : static_cast<char *>(p);
+    map_cap = map_base == nullptr ? 0 : cap;
+    return map_base != nullptr;
+  }
+
+  void close_mapped() {
+    if (map_base != nullptr) ::munmap(map_base, map_cap);
+    if (fd >= 0) ::close(fd);
+    map_base = nullptr;
+    map_cap = 0;
+    fd = -1;
+  }
+
+  void write_back(Page &page) {
+    if (!page.dirty) return;
+    long begin = static_cast<long>(page.block) * kRiverPageSize;
+    long len = file_end - begin;
+    if (len > kRiverPageSize) len = kRiverPageSize;
+    if (len > 0) {
+      file.clear();
+      file.seekp(begin, std::ios::beg);
+      file.write(page.data.data(), len);
+    }
+    page.dirty = false;
+  }
+
+  void evict_to(int capacity) {
+    while (static_cast<int>(pages.size()) > capacity) {
+      Page &victim = pages.back();
+      write_back(victim);
+      page_index.erase(victim.block);
+      pages.pop_back();
+    }
+  }
+
+  //取得块号为 block 的缓存页，未命中时从文件读入并按 LRU 淘汰
+  Page &fetch(int block) {
+    auto it = page_index.find(block);
+    if (it != page_index.end()) {
+      ++hits;
+      pages.splice(pages.begin(), pages, it->second);
+      return pages.front();
+    }
+    ++misses;
+    evict_to(cache_pages > 0 ? cache_pages - 1 : 0);
+
+    pages.push_front(Page());
+    Page &page = pages.front();
+    page.block = block;
+    page.dirty = false;
+    page.data.assign(kRiverPageSize, 0);
+    long begin = static_cast<long>(block) * kRiverPageSize;
+    if (begin < file_end) {
+      file.clear();
+      file.seekg(begin, std::ios::beg);
+      file.read(page.data.data(), kRiverPageSize);
+      file.clear();
+    }
+    page_index[block] = pages.begin();
+    return page;
+  }
+
+  void raw_load(char *dst, long pos, int len) {
+    if (mode == RiverMode::Mapped) {
+      //文件末尾之后的部分不可访问，按缓存模式的约定补零
+      long avail = file_end - pos;
+      if (avail < 0) avail = 0;
+      if (avail > len) avail = len;
+      if (avail > 0) std::memcpy(dst, map_base + pos, avail);
+      else avail = 0;
+      std::memset(dst + avail, 0, len - avail);
+      return;
+    }
+    while (len > 0) {
+      Page &page = fetch(static_cast<int>(pos / kRiverPageSize));
+      int offset = static_cast<int>(pos % kRiverPageSize);
+      int n = kRiverPageSize - offset;
+      if (n > len) n = len;
+      std::memcpy(dst, page.data.data() + offset, n);
+      dst += n;
+      pos += n;
+      len -= n;
+    }
+    evict_to(cache_pages);
+  }
+
+  void raw_store(const char *src, long pos, int len) {
+    if (mode == RiverMode::Mapped) {
+      bool mapped = true;
+      if (pos + len > file_end) {
+        mapped = ::ftruncate(fd, pos + len) == 0;
+        if (mapped) {
+          file_end = pos + len;
+          mapped = remap(file_end);
+        }
+      }
+      if (mapped) {
+        std::memcpy(map_base + pos, src, len);
+        return;
+      }
+      fall_back();
+    }
+    if (pos + len > file_end) file_end = pos + len;
+    while (len > 0) {
+      Page &page = fetch(static_cast<int>(pos / kRiverPageSize));
+      int offset = static_cast<int>(pos % kRiverPageSize);
+      int n = kRiverPageSize - offset;
+      if (n > len) n = len;
+      std::memcpy(page.data.data() + offset, src, n);
+      page.dirty = true;
+      src += n;
+      pos += n;
+      len -= n;
+    }
+    evict_to(cache_pages);
+  }
+
+  //丢弃全部缓存（不写回），用于文件被截断重建时
+  void drop_cache() {
+    pages.clear();
+    page_index.clear();
+  }
+
+  int header_size() const { return info_len * sizeof(int); }
+
+  int next_free(int index) {
+    int next = 0;
+    load_bytes(reinterpret_cast<char *>(&next), index + sizeofT - sizeof(int), sizeof(int));
+    return next;
+  }
+
+  void raw_shrink(long new_end) {
+    if (new_end >= file_end) return;
+    if (mode == RiverMode::Mapped) {
+      if (::ftruncate(fd, new_end) == 0) file_end = new_end;
+      return;
+    }
+    for (auto it = pages.begin(); it != pages.end();) {
+      long begin = static_cast<long>(it->block) * kRiverPageSize;
+      if (begin >= new_end) {
+        page_index.erase(it->block);
+        it = pages.erase(it);
+        continue;
+      }
+      if (begin + kRiverPageSize > new_end)
+        std::memset(it->data.data() + (new_end - begin), 0, begin + kRiverPageSize - new_end);
+      ++it;
+    }
+    file_end = new_end;
+    flush();
+    if (::truncate(file_name.c_str(), new_end) != 0) return;
+  }
+
+  void load_bytes(char *dst, long pos, int len) {
+    ensure_open();
+    raw_load(dst, pos, len);
+    //叠加尚未提交的修改
+    for (const auto &op : pending) {
+      if (op.size >= 0) {
+        if (op.size < pos + len) {
+          long from = op.size > pos ? op.size : pos;
+          std::memset(dst + (from - pos), 0, pos + len - from);
+        }
+        continue;
+      }
+      long lo = op.pos > pos ? op.pos : pos;
+      long hi = op.pos + static_cast<long>(op.bytes.size());
+      if (hi > pos + len) hi = pos + len;
+      if (lo < hi) std::memcpy(dst + (lo - pos), op.bytes.data() + (lo - op.pos), hi - lo);
+    }
+    //文件头以缓存为准
+    if (info_loaded && pos < header_size()) {
+      long hi = pos + len < header_size() ? pos + len : header_size();
+      std::memcpy(dst, reinterpret_cast<const char *>(info) + pos, hi - pos);
+    }
+  }
+
+  //先读到临时数组：load_bytes 会用 info 覆盖文件头部分，不能同时以它为目标
+  void load_info() {
+    if (info_loaded) return;
+    int header[info_len > 0 ? info_len : 1];
+    load_bytes(reinterpret_cast<char *>(header), 0, header_size());
+    std::memcpy(info, header, header_size());
+    info_loaded = true;
+  }
+
+  //把缓存的文件头写进文件（缓存模式下落到页缓存，之后由 write_back 写回）
+  void store_info() {
+    raw_store(reinterpret_cast<const char *>(info), 0, header_size());
+  }
+
+  void store_bytes(const char *src, long pos, int len) {
+    ensure_open();
+    if (!in_txn()) {
+      raw_store(src, pos, len);
+      return;
+    }
+    if (pending.empty()) {
+      journal->enlist(this);
+      txn_end = file_end;
+    } else {
+      //同一位置的重复写（如表头计数）直接覆盖上一次
+      PendingOp &last = pending.back();
+      if (last.size < 0 && last.pos == pos && static_cast<int>(last.bytes.size()) == len) {
+        last.bytes.assign(src, len);
+        return;
+      }
+    }
+    PendingOp op;
+    op.pos = pos;
+    op.size = -1;
+    op.bytes.assign(src, len);
+    pending.push_back(op);
+    if (pos + len > txn_end) txn_end = pos + len;
+  }
+
+  //提交前整理暂存的修改：事务中没有截短时，把各次写入合并成互不重叠的区间，
+  //只保留与事务开始前内容不同的字节段。同一页、同一节点在事务中被反复改写，
+  //或改写后大部分内容不变时，日志里只记实际变化的部分。
+  //超出原文件末尾的部分必须原样保留，以便延长文件。
+  //重放时以上次检查点之后的文件为底，而事务外的写入都在检查点前落盘，所以只记差异即可
+  void squash_pending() {
+    if (pending.empty()) return;
+    std::vector<std::pair<long, long>> spans;
+    for (const auto &op : pending) {
+      if (op.size >= 0) return;
+      spans.push_back(std::make_pair(op.pos, op.pos + static_cast<long>(op.bytes.size())));
+    }
+    std::sort(spans.begin(), spans.end());
+    size_t n = 0;
+    for (size_t k = 1; k < spans.size(); ++k) {
+      if (spans[k].first <= spans[n].second) spans[n].second = std::max(spans[n].second, spans[k].second);
+      else spans[++n] = spans[k];
+    }
+    spans.resize(n + 1);
+
+    std::vector<PendingOp> squashed;
+    string now, before;
+    for (const auto &span : spans) {
+      long lo = span.first, hi = span.second;
+      auto keep = [&](long pos, long len) {
+        PendingOp op;
+        op.pos = pos;
+        op.size = -1;
+        op.bytes.assign(now.data() + (pos - lo), len);
+        squashed.push_back(op);
+      };
+      now.resize(hi - lo);
+      load_bytes(&now[0], lo, static_cast<int>(hi - lo));
+      long old_hi = std::min(hi, std::max(lo, file_end));
+      before.resize(old_hi - lo);
+      if (old_hi > lo) raw_load(&before[0], lo, static_cast<int>(old_hi - lo));
+      long i = 0, len = old_hi - lo;
+      while (i < len) {
+        if (now[i] == before[i]) {
+          ++i;
+          continue;
+        }
+        long j = i + 1, last = i;
+        for (; j < len && j - last <= kJournalGap; ++j) {
+          if (now[j] != before[j]) last = j;
+        }
+        keep(lo + i, last + 1 - i);
+        i = last + 1;
+      }
+      if (old_hi < hi) keep(old_hi, hi - old_hi);
+    }
+    pending.swap(squashed);
+  }
+
+  //把文件截短到 new_end 字节
+  void shrink(long new_end) {
+    ensure_open();
+    if (!in_txn()) {
+      raw_shrink(new_end);
+      return;
+    }
+    if (new_end >= end()) return;
+    if (pending.empty()) journal->enlist(this);
+    PendingOp op;
+    op.pos = 0;
+    op.size = new_end;
+    pending.push_back(op);
+    txn_end = new_end;
+  }
+
 public:
   MemoryRiver() = default;
 
-  MemoryRiver(const string& file_name) : file_name(file_name) {}
+  MemoryRiver(const string& file_name, RiverMode mode = RiverMode::Cached,
+              int cache_pages = kRiverDefaultCachePages)
+      : file_name(file_name), mode(mode), cache_pages(cache_pages) {}
+
+  ~MemoryRiver() {
+    flush();
+    close_mapped();
+  }
+
+  //挂接日志；之后在 journal 的事务期间发生的修改由它统一提交
+  void set_journal(Journal *j) {
+    journal = j;
+    if (journal != nullptr) journal->attach(this);
+  }
+
+  void serialize_pending(string &out) override {
+    squash_pending();
+    for (const auto &op : pending) {
+      if (op.size >= 0) Journal::encode_truncate(out, file_name, op.size);
+      else Journal::encode_write(out, file_name, op.pos, op.bytes.data(), static_cast<int>(op.bytes.size()));
+    }
+    if (info_pending) Journal::encode_write(out, file_name, 0, reinterpret_cast<const char *>(info), header_size());
+  }
+
+  void apply_pending() override {
+    for (const auto &op : pending) {
+      if (op.size >= 0) raw_shrink(op.size);
+      else raw_store(op.bytes.data(), op.pos, static_cast<int>(op.bytes.size()));
+    }
+    pending.clear();
+    if (info_pending) store_info();
+    info_pending = false;
+  }
 
+  //写回并让文件内容落到磁盘
+  void sync() override {
+    flush();
+    if (mode == RiverMode::Mapped) {
+      if (map_base != nullptr && file_end > 0) ::msync(map_base, file_end, MS_SYNC);
+      if (fd >= 0) ::fsync(fd);
+      return;
+    }
+    int sync_fd = ::open(file_name.c_str(), O_RDONLY);
+    if (sync_fd < 0) return;
+    ::fsync(sync_fd);
+    ::close(sync_fd);
+  }
+
+  //让当前文件落盘后原子地改名为 target，覆盖同名旧文件，之后继续读写改名后的文件。
+  //迁移旧版数据时先写到临时文件再替换，中途崩溃时旧文件保持完整
+  bool replace(const string &target) {
+    sync();
+    if (::rename(file_name.c_str(), target.c_str()) != 0) return false;
+    file_name = target;
+    //目录项也要落盘，改名才算持久
+    string::size_type slash = target.rfind('/');
+    string dir = slash == string::npos ? "." : target.substr(0, slash + 1);
+    int dir_fd = ::open(dir.c_str(), O_RDONLY);
+    if (dir_fd >= 0) {
+      ::fsync(dir_fd);
+      ::close(dir_fd);
+    }
+    return true;
+  }
+
+  //重建文件；不受事务约束，只应在启动阶段调用
   void initialise(string FN = "") {
     if (FN != "") file_name = FN;
+    close_mapped();
+    drop_cache();
+    pending.clear();
+    free_cnt = -1;
+    std::memset(info, 0, sizeof(info));
+    info_loaded = true;
+    info_dirty = false;
+    info_pending = false;
+    if (file.is_open()) file.close();
+    file.clear();
     file.open(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
     int tmp = 0;
     for (int i = 0; i < info_len; ++i)
       file.write(reinterpret_cast<char *>(&tmp), sizeof(int));
     file.close();
+    ensure_open();
   }
 
   //读出第n个int的值赋给tmp，1_base
   void get_info(int &tmp, int n) {
     if (n > info_len) return;
-    file.open(file_name, std::ios::in | std::ios::binary);
-    file.seekg((n - 1) * sizeof(int), std::ios::beg);
-    file.read(reinterpret_cast<char*>(&tmp), sizeof(int));
-    file.close();
-    /* your code here */
+    ensure_open();
+    load_info();
+    tmp = info[n - 1];
   }
 
   //将tmp写入第n个int的位置，1_base
+  //文件头尚未写入过（文件比文件头短）时直接写入，保证之后的对象不会落在文件头里
   void write_info(int tmp, int n) {
     if (n > info_len) return;
-    file.open(file_name, std::ios::in | std::ios::out | std::ios::binary);
-    file.seekp((n - 1) * sizeof(int), std::ios::beg);
-    file.write(reinterpret_cast<char *>(&tmp), sizeof(int));
-    file.close();
-    /* your code here */
+    ensure_open();
+    load_info();
+    info[n - 1] = tmp;
+    if (end() < header_size()) {
+      store_bytes(reinterpret_cast<const char *>(info), 0, header_size());
+    } else if (in_txn()) {
+      if (!info_pending) journal->enlist(this);
+      info_pending = true;
+    } else {
+      info_dirty = true;
+    }
   }
 
   //在文件合适位置写入类对象t，并返回写入的位置索引index
   //位置索引意味着当输入正确的位置索引index，在以下三个函数中都能顺利的找到目标对象进行操作
   //位置索引index可以取为对象写入的起始位置
+  //启用空间回收时优先复用空闲槽位
   int write(T &t) {
-    file.open(file_name, std::ios::app | std::ios::binary);
-    file.seekp(0, std::ios::end);
-    int index = file.tellp();
-    file.write(reinterpret_cast<char *>(&t), sizeof(T));
-    file.close();
+    ensure_open();
+    if (free_slot > 0) {
+      int head = 0;
+      get_info(head, free_slot);
+      if (head != 0) {
+        write_info(next_free(head), free_slot);
+        if (free_cnt > 0) --free_cnt;
+        store_bytes(reinterpret_cast<char *>(&t), head, sizeofT);
+        return head;
+      }
+    }
+    int index = static_cast<int>(end());
+    store_bytes(reinterpret_cast<char *>(&t), index, sizeofT);
     return index;
-    /* your code here */
   }
 
   //用t的值更新位置索引index对应的对象，保证调用的index都是由write函数产生
   void update(T &t, const int index) {
-    file.open(file_name, std::ios::in | std::ios::out | std::ios::binary);
-    file.seekp(index, std::ios::beg);
-    file.write(reinterpret_cast<char *>(&t), sizeof(T));
-    file.close();
-    /* your code here */
+    store_bytes(reinterpret_cast<char *>(&t), index, sizeofT);
   }
 
   //读出位置索引index对应的T对象的值并赋值给t，保证调用的index都是由write函数产生
   void read(T &t, const int index) {
-    file.open(file_name, std::ios::in | std::ios::binary);
-    file.seekg(index, std::ios::beg);
-    file.read(reinterpret_cast<char *>(&t), sizeof(T));
-    file.close();
-    /* your code here */
+    load_bytes(reinterpret_cast<char *>(&t), index, sizeofT);
+  }
+
+  //按字节读写位置索引 index 起的 len 字节，只需访问对象的一部分时使用
+  void read_bytes(void *dst, const int index, int len) {
+    load_bytes(static_cast<char *>(dst), index, len);
+  }
+
+  void update_bytes(const void *src, const int index, int len) {
+    store_bytes(static_cast<const char *>(src), index, len);
+  }
+
+  //批量读写第 first 个槽位（0_base）起的 count 个连续对象，只做一次定位和一次拷贝
+  void read_range(int first, int count, T *out) {
+    if (count <= 0) return;
+    load_bytes(reinterpret_cast<char *>(out), record_pos(first), count * sizeofT);
+  }
+
+  void write_range(int first, int count, const T *src) {
+    if (count <= 0) return;
+    store_bytes(reinterpret_cast<const char *>(src), record_pos(first), count * sizeofT);
+  }
+
+  //把 count 个对象一次追加到文件末尾（不复用空闲槽位），返回第一个对象的位置索引
+  int append_range(const T *src, int count) {
+    ensure_open();
+    int index = static_cast<int>(end());
+    if (count > 0) store_bytes(reinterpret_cast<const char *>(src), index, count * sizeofT);
+    return index;
   }
 
   //删除位置索引index对应的对象(不涉及空间回收时，可忽略此函数)，保证调用的index都是由write函数产生
+  //槽位被清零后挂到空闲链表表头，之后的 write 会复用它
   void Delete(int index) {
-    /* your code here */
+    if (free_slot == 0) return;
+    std::vector<char> blank(sizeofT, 0);
+    int head = 0;
+    get_info(head, free_slot);
+    std::memcpy(blank.data() + sizeofT - sizeof(int), &head, sizeof(int));
+    store_bytes(blank.data(), index, sizeofT);
+    write_info(index, free_slot);
+    if (free_cnt >= 0) ++free_cnt;
   }
+
+  //文件中的槽位总数（含空闲槽位）
+  int slot_count() {
+    ensure_open();
+    if (end() <= header_size()) return 0;
+    return static_cast<int>((end() - header_size()) / sizeofT);
+  }
+
+  int free_count() {
+    if (free_slot == 0) return 0;
+    if (free_cnt < 0) {
+      free_cnt = 0;
+      int head = 0;
+      get_info(head, free_slot);
+      for (; head != 0; head = next_free(head)) ++free_cnt;
+    }
+    return free_cnt;
+  }
+
+  //在线压缩：把末尾的有效对象搬进前面的空洞并截短文件，返回剩余槽位数。
+  //每搬动一个对象调用 on_move(old_index, new_index)，供调用方修正索引
+  template<class F>
+  int compact(F on_move) {
+    if (free_slot == 0) return slot_count();
+    int slots = slot_count();
+    const int header = header_size();
+    std::vector<bool> is_free(slots, false);
+    int head = 0;
+    get_info(head, free_slot);
+    for (; head != 0; head = next_free(head)) is_free[(head - header) / sizeofT] = true;
+
+    std::vector<char> buf(sizeofT);
+    int lo = 0, hi = slots - 1;
+    while (true) {
+      while (lo < hi && !is_free[lo]) ++lo;
+      while (hi > lo && is_free[hi]) --hi;
+      if (lo >= hi) break;
+      int from = header + hi * sizeofT, to = header + lo * sizeofT;
+      load_bytes(buf.data(), from, sizeofT);
+      store_bytes(buf.data(), to, sizeofT);
+      on_move(from, to);
+      is_free[lo] = false;
+      is_free[hi] = true;
+    }
+
+    int live = 0;
+    while (live < slots && !is_free[live]) ++live;
+    write_info(0, free_slot);
+    free_cnt = 0;
+    shrink(header + static_cast<long>(live) * sizeofT);
+    return live;
+  }
+
+  //只保留前 count 个槽位，截掉之后的部分
+  void truncate(int count) {
+    shrink(record_pos(count));
+  }
+
+  //文件头之后第 i 个槽位（0_base）的位置索引
+  int record_pos(int i) const { return header_size() + i * sizeofT; }
+
+  //顺序读出槽位 [first, last) 中的对象：每次读入约 kRiverScanBytes 字节到复用的缓冲区，
+  //再逐个交出，扫描占用的内存与记录数无关。事务期间读到的是叠加了未提交修改的内容
+  class Cursor {
+  public:
+    Cursor(MemoryRiver &river, int first, int last)
+        : river(river), buffer(chunk_size()), next_slot(first), last_slot(last) {}
+
+    //下一个对象，指针在下一次调用 next / seek 前有效；读完时返回 nullptr
+    const T *next() {
+      if (cur + 1 < filled) return &buffer[++cur];
+      if (next_slot >= last_slot) return nullptr;
+      filled = last_slot - next_slot;
+      if (filled > static_cast<int>(buffer.size())) filled = static_cast<int>(buffer.size());
+      river.read_range(next_slot, filled, buffer.data());
+      base = next_slot;
+      next_slot += filled;
+      cur = 0;
+      return &buffer[0];
+    }
+
+    bool next(T &t) {
+      const T *p = next();
+      if (p == nullptr) return false;
+      t = *p;
+      return true;
+    }
+
+    //跳过不满足 pred 的对象；pred 直接作用于缓冲区中的对象，不做拷贝
+    template<class Pred>
+    const T *next_if(Pred pred) {
+      const T *p;
+      while ((p = next()) != nullptr && !pred(*p)) {}
+      return p;
+    }
+
+    //之后从槽位 i 继续读，i 在已读入的范围内时不重新读文件
+    void seek(int i) {
+      if (i >= base && i < base + filled) {
+        cur = i - base - 1;
+        return;
+      }
+      next_slot = i;
+      filled = 0;
+      cur = -1;
+    }
+
+    //上一次交出的对象的槽位号与位置索引
+    int slot() const { return base + cur; }
+    int pos() const { return river.record_pos(slot()); }
+
+  private:
+    MemoryRiver &river;
+    std::vector<T> buffer;
+    int next_slot;      //缓冲区之后的第一个槽位
+    int last_slot;
+    int base = 0;       //buffer[0] 对应的槽位
+    int filled = 0;     //缓冲区中的有效对象数
+    int cur = -1;       //上一次交出的对象在缓冲区中的下标
+
+    static int chunk_size() {
+      int n = kRiverScanBytes / static_cast<int>(sizeof(T));
+      return n > 0 ? n : 1;
+    }
+  };
+
+  //last < 0 表示扫到文件末尾
+  Cursor scan(int first = 0, int last = -1) {
+    return Cursor(*this, first, last < 0 ? slot_count() : last);
+  }
+
+  //对槽位 [first, last) 中满足 pred 的对象依次调用 f(t, index)
+  template<class Pred, class F>
+  void for_each(int first, int last, Pred pred, F f) {
+    Cursor cursor = scan(first, last);
+    while (const T *p = cursor.next_if(pred)) f(*p, cursor.pos());
+  }
+
+  //把所有脏块按块号顺序写回文件，最后写文件头；映射模式下由内核负责写回
+  void flush() {
+    if (info_dirty && (map_base != nullptr || file.is_open())) {
+      if (map_base != nullptr && file_end > 0) ::msync(map_base, file_end, MS_SYNC);
+      store_info();
+      info_dirty = false;
+    }
+    if (map_base != nullptr && file_end > 0) ::msync(map_base, file_end, MS_ASYNC);
+    if (!file.is_open()) return;
+    std::vector<Page *> dirty;
+    for (auto &page : pages)
+      if (page.dirty && page.block != 0) dirty.push_back(&page);
+    std::sort(dirty.begin(), dirty.end(),
+              [](const Page *a, const Page *b) { return a->block < b->block; });
+    for (Page *page : dirty) write_back(*page);
+    file.flush();
+    auto head = page_index.find(0);
+    if (head != page_index.end()) write_back(*head->second);
+    file.flush();
+  }
+
+  //调整页缓存容量（块数），0 表示不缓存
+  void set_cache_pages(int n) {
+    cache_pages = n < 0 ? 0 : n;
+    evict_to(cache_pages);
+  }
+
+  RiverMode storage_mode() const { return mode; }
+  int cache_capacity() const { return cache_pages; }
+  long long cache_hits() const { return hits; }
+  long long cache_misses() const { return misses; }
 };
 
 
-#endif //BPT_MEMORYRIVER_HPP
\ No newline at end of file
+#endif //BPT_MEMORYRIVER_HPP
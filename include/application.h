@@ -4,6 +4,7 @@
 #include "book.h"
 #include "command.h"
 #include "finance.h"
+#include "journal.h"
 #include "log.h"
 #include "session.h"
 #include "user.h"
@@ -11,9 +12,11 @@
 class Application {
 public:
     Application();
+    ~Application();
     void run();
 
 private:
+    Journal journal;  // 须先于各模块构造：启动时先重放日志，再打开数据文件
     CommandParser parser;
     SessionStack sessions;
     AccountManager account_manager;
@@ -25,6 +28,6 @@ private:
     void handle_show_finance(const std::vector<std::string> &args);
     void handle_report_finance();
     void handle_report_employee();
-    void handle_log();
-    void show_books_with_criteria(const std::string &criteria);
+    void handle_log(const std::vector<std::string> &args);
+    void show_books_with_criteria(const std::vector<std::string> &criteria);
 };
@@ -0,0 +1,258 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+#include "MemoryRiver.h"
+
+// 持久化的块状链表：按 (key, value) 升序存放键值对，同一个 key 可以对应多个 value。
+// Key / Value 需提供 operator< 与 operator==，且能按字节写入文件。
+// 每块最多 block_size 条记录，块满时对半分裂；相邻两块合起来不足半块时合并，
+// 空出的块由 MemoryRiver 的空闲链表回收。定位时只读各块的块头和末条记录。
+template<class Key, class Value, int block_size = 256>
+class BlockList {
+public:
+    explicit BlockList(const std::string &file_name) : file(file_name) {}
+
+    // 清空并重建为只有一个空块的链表
+    void initialise() {
+        file.initialise();
+        Block head;
+        blank(head);
+        file.write_info(file.write(head), 1);
+        file.write_info(0, 2);
+    }
+
+    // 重建结束时调用：内容先落盘，再写入完整标记并落盘
+    void mark_complete() {
+        file.sync();
+        file.write_info(kIndexComplete, 4);
+        file.sync();
+    }
+
+    // 文件带有完整标记；重建中途崩溃留下的文件没有标记
+    bool complete() {
+        int mark = 0;
+        file.get_info(mark, 4);
+        return mark == kIndexComplete;
+    }
+
+    void set_journal(Journal *journal) { file.set_journal(journal); }
+
+    // (key, value) 已存在时返回 false
+    bool insert(const Key &key, const Value &value) {
+        Entry target;
+        blank(target);
+        target.key = key;
+        target.value = value;
+
+        int prev = 0;
+        int pos = locate(target, false, prev);
+        Block block;
+        read_block(block, pos);
+
+        int i = lower_bound(block, target);
+        if (i < block.count && equal(block.entries[i], target)) return false;
+        for (int j = block.count; j > i; --j) block.entries[j] = block.entries[j - 1];
+        block.entries[i] = target;
+        ++block.count;
+        add_size(1);
+
+        if (block.count < block_size) {
+            write_block(block, pos);
+            return true;
+        }
+
+        // 块满：后一半移到紧随其后的新块
+        Block tail;
+        blank(tail);
+        int half = block.count / 2;
+        tail.count = block.count - half;
+        for (int j = 0; j < tail.count; ++j) tail.entries[j] = block.entries[half + j];
+        tail.next = block.next;
+        block.count = half;
+        block.next = file.write(tail);
+        write_block(block, pos);
+        return true;
+    }
+
+    // (key, value) 不存在时返回 false
+    bool erase(const Key &key, const Value &value) {
+        Entry target;
+        target.key = key;
+        target.value = value;
+
+        int prev = 0;
+        int pos = locate(target, false, prev);
+        Block block;
+        read_block(block, pos);
+
+        int i = lower_bound(block, target);
+        if (i == block.count || !equal(block.entries[i], target)) return false;
+        for (int j = i; j + 1 < block.count; ++j) block.entries[j] = block.entries[j + 1];
+        --block.count;
+        add_size(-1);
+
+        if (block.next != 0) {
+            int next_count = 0;
+            file.read_bytes(&next_count, block.next, sizeof(int));
+            if (block.count + next_count <= block_size / 2) {
+                // 与后继块合并，后继块的槽位回收
+                Block next;
+                read_block(next, block.next);
+                for (int j = 0; j < next.count; ++j) block.entries[block.count + j] = next.entries[j];
+                block.count += next.count;
+                int freed = block.next;
+                block.next = next.next;
+                file.Delete(freed);
+            }
+        }
+
+        if (block.count == 0 && prev != 0) {
+            // 非首块变空：从链表中摘除
+            file.update_bytes(&block.next, prev + static_cast<int>(offsetof(Block, next)), sizeof(int));
+            file.Delete(pos);
+            return true;
+        }
+        write_block(block, pos);
+        return true;
+    }
+
+    // key 对应的全部 value，按 value 升序
+    std::vector<Value> find(const Key &key) {
+        std::vector<Value> result;
+        for_range(key, key, [&](const Key &, const Value &value) { result.push_back(value); });
+        return result;
+    }
+
+    // 按 (key, value) 升序对 lo <= key <= hi 的每条记录调用 f(key, value)
+    template<class F>
+    void for_range(const Key &lo, const Key &hi, F f) {
+        Entry target;
+        target.key = lo;
+        int prev = 0;
+        int pos = locate(target, true, prev);
+        Block block;
+        while (pos != 0) {
+            read_block(block, pos);
+            for (int i = 0; i < block.count; ++i) {
+                const Entry &e = block.entries[i];
+                if (e.key < lo) continue;
+                if (hi < e.key) return;
+                f(e.key, e.value);
+            }
+            pos = block.next;
+        }
+    }
+
+    // 按 (key, value) 升序对每条记录调用 f(key, value)
+    template<class F>
+    void for_each(F f) {
+        int pos = head();
+        Block block;
+        while (pos != 0) {
+            read_block(block, pos);
+            for (int i = 0; i < block.count; ++i) f(block.entries[i].key, block.entries[i].value);
+            pos = block.next;
+        }
+    }
+
+    int size() {
+        head();
+        int n = 0;
+        file.get_info(n, 2);
+        return n;
+    }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+    };
+
+    struct Block {
+        int count;
+        int next;  // 后继块的位置，0 表示链表结束
+        Entry entries[block_size];
+    };
+
+    MemoryRiver<Block, 4, 3> file;  // info1: 首块位置, info2: 记录数, info3: 空闲链表表头, info4: 完整标记
+
+    // 写入文件的块和记录先清零，未用的槽位和填充字节不会把内存中的残留写进文件
+    template<class T>
+    static void blank(T &object) {
+        std::memset(static_cast<void *>(&object), 0, sizeof(T));
+    }
+
+    static bool less(const Entry &a, const Entry &b) {
+        if (a.key < b.key) return true;
+        if (b.key < a.key) return false;
+        return a.value < b.value;
+    }
+
+    static bool equal(const Entry &a, const Entry &b) {
+        return a.key == b.key && a.value == b.value;
+    }
+
+    static int lower_bound(const Block &block, const Entry &target) {
+        int lo = 0, hi = block.count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (less(block.entries[mid], target)) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    int head() {
+        int pos = 0;
+        file.get_info(pos, 1);
+        if (pos == 0) {
+            initialise();
+            file.get_info(pos, 1);
+        }
+        return pos;
+    }
+
+    void add_size(int delta) {
+        int n = 0;
+        file.get_info(n, 2);
+        file.write_info(n + delta, 2);
+    }
+
+    // 找到第一个末条记录不小于 target 的块（by_key 时只比较 key），没有则返回末块；
+    // prev 为其前驱块的位置，首块的前驱为 0
+    int locate(const Entry &target, bool by_key, int &prev) {
+        prev = 0;
+        int pos = head();
+        while (true) {
+            int header[2];
+            file.read_bytes(header, pos, sizeof(header));
+            int count = header[0], next = header[1];
+            if (next == 0) return pos;
+            if (count > 0) {
+                Entry last;
+                file.read_bytes(&last, pos + entry_offset(count - 1), sizeof(Entry));
+                bool reached = by_key ? !(last.key < target.key) : !less(last, target);
+                if (reached) return pos;
+            }
+            prev = pos;
+            pos = next;
+        }
+    }
+
+    static int entry_offset(int i) {
+        return static_cast<int>(offsetof(Block, entries) + i * sizeof(Entry));
+    }
+
+    // 只读写块头和有效记录
+    void read_block(Block &block, int pos) {
+        file.read_bytes(&block, pos, entry_offset(0));
+        file.read_bytes(block.entries, pos + entry_offset(0), block.count * sizeof(Entry));
+    }
+
+    void write_block(Block &block, int pos) {
+        file.update_bytes(&block, pos, entry_offset(block.count));
+    }
+};
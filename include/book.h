@@ -4,6 +4,11 @@
 #include <utility>
 
 #include "MemoryRiver.h"
+#include "block_list.h"
+#include "catalog.h"
+#include "bplus_tree.h"
+#include "fixed_string.h"
+#include "lru_cache.h"
 #include "session.h"
 
 struct Book {
@@ -20,15 +25,54 @@ struct Book {
          double p = 0.0, int q = 0);
 };
 
+// books.dat 中的一条记录。定长部分只有 ISBN、数量、价格（分）和三段文字的长度；
+// 书名、作者、关键词首尾相接存放在 books.str 中，从位置 text 开始，只在需要时读出
+struct BookRecord {
+    char isbn[21];
+    unsigned char name_len;
+    unsigned char author_len;
+    unsigned char keywords_len;
+    int text;
+    int quantity;
+    long long price_cents;
+
+    BookRecord();
+    int text_len() const { return name_len + author_len + keywords_len; }
+};
+
+// 二级索引中的值：图书的 ISBN 与其在 books.dat 中的位置，按 ISBN 排序
+struct BookRef {
+    FixedString<20> isbn;
+    int pos;
+
+    BookRef() : pos(0) {}
+    BookRef(const FixedString<20> &i, int p) : isbn(i), pos(p) {}
+
+    bool operator<(const BookRef &other) const {
+        if (isbn != other.isbn) return isbn < other.isbn;
+        return pos < other.pos;
+    }
+    bool operator==(const BookRef &other) const {
+        return isbn == other.isbn && pos == other.pos;
+    }
+};
+
+// show 的筛选条件，空串表示不限；多个条件同时满足才输出
+struct BookFilter {
+    std::string isbn;
+    std::string name;
+    std::string author;
+    std::string keyword;
+};
+
 class BookManager {
 public:
     BookManager();
+    // 之后在事务期间对本模块文件的修改都经由 journal 提交
+    void attach_journal(Journal &journal);
 
     void show_all();
-    void show_by_isbn(const std::string &isbn);
-    void show_by_name(const std::string &name);
-    void show_by_author(const std::string &author);
-    void show_by_keyword(const std::string &keyword);
+    void show_matching(const BookFilter &filter);
 
     bool buy(const std::string &isbn, int quantity, double &total_cost);
 
@@ -40,11 +84,47 @@ public:
     bool import(const int &selected_pos,
                 int quantity, double total_cost);
 
+    // 图书缓存的容量（本数）与命中统计
+    void set_cache_capacity(int n) { book_cache.set_capacity(n); }
+    long long cache_hits() const { return book_cache.hits(); }
+    long long cache_misses() const { return book_cache.misses(); }
+
+    // 开启后把全部图书载入常驻内存的列式目录，show 直接在内存中筛选；
+    // 这违背主体数据不常驻内存的约定，默认关闭，只用于读多写少的部署
+    void set_resident_catalog(bool on);
+
 private:
-    MemoryRiver<Book, 1> book_file;
+    typedef FixedString<20> IsbnKey;
+    typedef FixedString<60> TextKey;
+    typedef BlockList<TextKey, BookRef> TextIndex;
+
+    // 缓存中的一条图书记录及其在 books.dat 中的位置
+    struct CachedBook {
+        BookRecord record;
+        int pos;
+    };
+
+    MemoryRiver<BookRecord, 2> book_file;  // info1: 记录数, info2: 格式标记
+    MemoryRiver<char, 1> text_file;        // 只追加的文字堆，修改文字时旧内容不回收
+    BPlusTree<IsbnKey, int> isbn_index;  // ISBN -> books.dat 中的位置
+    TextIndex name_index;                // 书名 -> (ISBN, 位置)
+    TextIndex author_index;              // 作者 -> (ISBN, 位置)
+    TextIndex keyword_index;             // 单个关键词 -> (ISBN, 位置)
+    // ISBN -> 最近访问的图书记录；books.dat 的每次修改都同步写入，ISBN 变化时移除旧键
+    LruCache<std::string, CachedBook> book_cache;
+    BookCatalog catalog;
+    bool resident = false;
 
-    bool find_by_isbn(const std::string &isbn_str, Book &book, int &index);
-    std::vector<Book> get_all_books();
+    void upgrade_legacy_file();
+    bool find_by_isbn(const std::string &isbn_str, BookRecord &record, int &index);
+    void store_record(const BookRecord &record, int pos);
+    void load_book(const BookRecord &record, Book &book);
+    void store_text(const Book &book, BookRecord &record);
+    int row_of(int pos) const;
+    void rebuild_indexes();
+    void reindex(const Book &old_book, const Book &new_book, int pos);
+    static bool may_match(const BookRecord &record, const BookFilter &filter);
+    static bool matches(const Book &book, const BookFilter &filter);
     void print_book(const Book &book);
     bool validate_isbn(const std::string &isbn);
     bool validate_string_no_quotes(const std::string &str);
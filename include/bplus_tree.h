@@ -0,0 +1,270 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "MemoryRiver.h"
+
+// 持久化的 B+ 树：Key -> Value，键唯一，叶子按键升序串成链表。
+// Key 需提供 operator< 与 operator==，Key / Value 须能按字节写入文件。
+// 每个结点占一个 4 KiB 左右的页；点查询读 O(log n) 个页，for_each 沿叶子链表顺序遍历。
+// 删除只从叶子中移除记录，不做合并。
+template<class Key, class Value>
+class BPlusTree {
+public:
+    explicit BPlusTree(const std::string &file_name) : file(file_name) {}
+
+    // 清空并重建为只有一个空叶子的树
+    void initialise() {
+        file.initialise();
+        Node leaf;
+        blank(leaf);
+        leaf.is_leaf = 1;
+        int pos = file.write(leaf);
+        file.write_info(pos, 1);
+        file.write_info(pos, 2);
+        file.write_info(0, 3);
+    }
+
+    // 重建结束时调用：内容先落盘，再写入完整标记并落盘
+    void mark_complete() {
+        file.sync();
+        file.write_info(kIndexComplete, 4);
+        file.sync();
+    }
+
+    // 文件带有完整标记；重建中途崩溃留下的文件没有标记
+    bool complete() {
+        int mark = 0;
+        file.get_info(mark, 4);
+        return mark == kIndexComplete;
+    }
+
+    void set_journal(Journal *journal) { file.set_journal(journal); }
+
+    bool find(const Key &key, Value &value) {
+        Node node;
+        descend(key, node, nullptr);
+        int i = lower_bound(node, key);
+        if (i == node.count || !(node.keys[i] == key)) return false;
+        value = node.values[i];
+        return true;
+    }
+
+    // 键已存在时返回 false
+    bool insert(const Key &key, const Value &value) {
+        std::vector<int> path;
+        Node node;
+        int pos = descend(key, node, &path);
+        int i = lower_bound(node, key);
+        if (i < node.count && node.keys[i] == key) return false;
+
+        for (int j = node.count; j > i; --j) {
+            node.keys[j] = node.keys[j - 1];
+            node.values[j] = node.values[j - 1];
+        }
+        node.keys[i] = key;
+        node.values[i] = value;
+        ++node.count;
+        add_size(1);
+
+        if (node.count < kOrder) {
+            file.update(node, pos);
+            return true;
+        }
+
+        // 叶子满了：右半部分移到新叶子，新叶子的首键作为分隔键插入父结点
+        Node right;
+        blank(right);
+        right.is_leaf = 1;
+        int mid = node.count / 2;
+        right.count = node.count - mid;
+        for (int j = 0; j < right.count; ++j) {
+            right.keys[j] = node.keys[mid + j];
+            right.values[j] = node.values[mid + j];
+        }
+        node.count = mid;
+        right.next = node.next;
+        int right_pos = file.write(right);
+        node.next = right_pos;
+        file.update(node, pos);
+
+        Key sep = right.keys[0];
+        int child = right_pos;
+        while (!path.empty()) {
+            int parent_pos = path.back();
+            path.pop_back();
+            Node parent;
+            file.read(parent, parent_pos);
+
+            int j = upper_bound(parent, sep);
+            for (int k = parent.count; k > j; --k) {
+                parent.keys[k] = parent.keys[k - 1];
+                parent.children[k + 1] = parent.children[k];
+            }
+            parent.keys[j] = sep;
+            parent.children[j + 1] = child;
+            ++parent.count;
+
+            if (parent.count < kOrder) {
+                file.update(parent, parent_pos);
+                return true;
+            }
+
+            // 内部结点满了：中间的键上移，右半部分移到新结点
+            Node upper;
+            blank(upper);
+            int half = parent.count / 2;
+            upper.count = parent.count - half - 1;
+            for (int k = 0; k < upper.count; ++k) upper.keys[k] = parent.keys[half + 1 + k];
+            for (int k = 0; k <= upper.count; ++k) upper.children[k] = parent.children[half + 1 + k];
+            sep = parent.keys[half];
+            parent.count = half;
+            file.update(parent, parent_pos);
+            child = file.write(upper);
+        }
+
+        // 根结点分裂，树长高一层
+        int old_root = 0;
+        file.get_info(old_root, 1);
+        Node root;
+        blank(root);
+        root.count = 1;
+        root.keys[0] = sep;
+        root.children[0] = old_root;
+        root.children[1] = child;
+        file.write_info(file.write(root), 1);
+        return true;
+    }
+
+    // 修改已有键对应的值，键不存在时返回 false
+    bool update(const Key &key, const Value &value) {
+        Node node;
+        int pos = descend(key, node, nullptr);
+        int i = lower_bound(node, key);
+        if (i == node.count || !(node.keys[i] == key)) return false;
+        node.values[i] = value;
+        file.update(node, pos);
+        return true;
+    }
+
+    bool erase(const Key &key) {
+        Node node;
+        int pos = descend(key, node, nullptr);
+        int i = lower_bound(node, key);
+        if (i == node.count || !(node.keys[i] == key)) return false;
+        for (int j = i; j + 1 < node.count; ++j) {
+            node.keys[j] = node.keys[j + 1];
+            node.values[j] = node.values[j + 1];
+        }
+        --node.count;
+        file.update(node, pos);
+        add_size(-1);
+        return true;
+    }
+
+    // 按键升序对 lo <= key <= hi 的每条记录调用 f(key, value)
+    template<class F>
+    void for_range(const Key &lo, const Key &hi, F f) {
+        Node node;
+        descend(lo, node, nullptr);
+        while (true) {
+            for (int i = lower_bound(node, lo); i < node.count; ++i) {
+                if (hi < node.keys[i]) return;
+                f(node.keys[i], node.values[i]);
+            }
+            if (node.next == 0) return;
+            file.read(node, node.next);
+        }
+    }
+
+    int size() {
+        ensure_root();
+        int n = 0;
+        file.get_info(n, 3);
+        return n;
+    }
+
+    // 按键升序对每条记录调用 f(key, value)
+    template<class F>
+    void for_each(F f) {
+        ensure_root();
+        int pos = 0;
+        file.get_info(pos, 2);
+        Node node;
+        while (pos != 0) {
+            file.read(node, pos);
+            for (int i = 0; i < node.count; ++i) f(node.keys[i], node.values[i]);
+            pos = node.next;
+        }
+    }
+
+private:
+    static const int kPageBytes = 4096;
+    static const int kOrder = static_cast<int>(
+        (kPageBytes - 4 * sizeof(int)) / (sizeof(Key) + sizeof(Value) + sizeof(int)));
+
+    struct Node {
+        int is_leaf;
+        int count;                 // 叶子：记录数；内部结点：分隔键数
+        int next;                  // 叶子：右侧兄弟的位置，0 表示没有
+        Key keys[kOrder];
+        Value values[kOrder];      // 仅叶子使用
+        int children[kOrder + 1];  // 仅内部结点使用，children[i] 中的键都 < keys[i]
+    };
+
+    MemoryRiver<Node, 4> file;  // info1: 根结点位置, info2: 最左叶子位置, info3: 记录数, info4: 完整标记
+
+    // 新结点先整页清零，未用的键、值、子结点槽位和填充字节不会把内存中的残留写进文件
+    static void blank(Node &node) {
+        std::memset(static_cast<void *>(&node), 0, sizeof(Node));
+    }
+
+    void ensure_root() {
+        int root = 0;
+        file.get_info(root, 1);
+        if (root == 0) initialise();
+    }
+
+    void add_size(int delta) {
+        int n = 0;
+        file.get_info(n, 3);
+        file.write_info(n + delta, 3);
+    }
+
+    // 第一个 >= key 的位置
+    static int lower_bound(const Node &node, const Key &key) {
+        int lo = 0, hi = node.count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (node.keys[mid] < key) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // 第一个 > key 的位置
+    static int upper_bound(const Node &node, const Key &key) {
+        int lo = 0, hi = node.count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (key < node.keys[mid]) hi = mid;
+            else lo = mid + 1;
+        }
+        return lo;
+    }
+
+    // 从根走到 key 所在的叶子，path 非空时记录沿途内部结点的位置
+    int descend(const Key &key, Node &node, std::vector<int> *path) {
+        ensure_root();
+        int pos = 0;
+        file.get_info(pos, 1);
+        file.read(node, pos);
+        while (!node.is_leaf) {
+            if (path != nullptr) path->push_back(pos);
+            pos = node.children[upper_bound(node, key)];
+            file.read(node, pos);
+        }
+        return pos;
+    }
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "fixed_string.h"
+
+struct Book;
+struct BookFilter;
+
+// 常驻内存的图书目录（列式存储）：第 row 行对应 books.dat 的第 row 个槽位，
+// 每个字段各占一个连续数组。书名、作者、整串关键词和单个关键词都换成编号，
+// 筛选只比较整数；keyword_bits 按关键词编号对 64 取模置位，先用它排除不含该关键词的行。
+// 会把全部图书放进内存，只在显式开启时使用。
+class BookCatalog {
+public:
+    void clear();
+    int size() const { return static_cast<int>(isbn.size()); }
+
+    // 第 row 行改为 book；row 等于当前行数时追加一行
+    void put(int row, const Book &book);
+    void set_quantity(int row, int quantity) { this->quantity[row] = quantity; }
+
+    // 按 ISBN 升序输出满足 filter 的行，返回输出的行数
+    int show(const BookFilter &filter);
+
+private:
+    // 字符串与编号的双向映射
+    struct Dictionary {
+        std::vector<std::string> words;
+        std::unordered_map<std::string, int> ids;
+
+        int intern(const std::string &word);
+        int find(const std::string &word) const;
+    };
+
+    Dictionary texts;     // 书名、作者、整串关键词
+    Dictionary keywords;  // 单个关键词
+
+    std::vector<FixedString<20>> isbn;
+    std::vector<int> name_id;
+    std::vector<int> author_id;
+    std::vector<int> keywords_id;
+    std::vector<uint64_t> keyword_bits;
+    std::vector<int> keyword_first;      // 该行的关键词编号在 keyword_pool 中的起点
+    std::vector<int> keyword_count;
+    std::vector<int> keyword_pool;       // 只追加，修改关键词时旧的编号不回收
+    std::vector<long long> price_cents;
+    std::vector<int> quantity;
+    std::vector<int> order;              // 按 ISBN 升序排列的行号
+
+    int order_position(const FixedString<20> &key) const;
+    bool has_keyword(int row, int id) const;
+    void print_row(int row) const;
+};
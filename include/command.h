@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <cstring>
 
 enum class CommandType {
     Empty,
@@ -29,11 +30,30 @@ struct Command {
     std::vector<std::string> args;
 };
 
+// 指向原始行中一段字符的只读视图
+struct StrView {
+    const char *data;
+    size_t size;
+
+    bool operator==(const char *s) const {
+        return std::strlen(s) == size && std::memcmp(data, s, size) == 0;
+    }
+};
+
+enum class LineStatus {
+    Blank,  // 空行或只含空格
+    Bad,    // 含空格以外的不可见字符或非 ASCII 字符
+    Ok
+};
+
+// 一遍扫描完成合法性检查和切分，记号是指向原始行的视图；
+// Command 和记号数组在各行之间复用，稳定后解析不再分配内存。
 class CommandParser {
 public:
-    Command parse(const std::string &line);
+    LineStatus parse(const std::string &line, Command &cmd);
 
 private:
-    std::vector<std::string> split(const std::string &line);
-    std::string trim(const std::string &str);
+    std::vector<StrView> tokens;
+
+    LineStatus split(const std::string &line);
 };
\ No newline at end of file
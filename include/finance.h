@@ -3,17 +3,21 @@
 
 #include "MemoryRiver.h"
 
+// 截至这一笔交易（含）的累计收入与支出，单位为分。
+// 最近 n 笔的收支即末条记录与倒数第 n+1 条记录之差。
 struct FinanceRecord {
-    bool is_income;
-    double amount;
+    long long income_cents;
+    long long expense_cents;
 
-    FinanceRecord(bool income = false, double amt = 0.0)
-        : is_income(income), amount(amt) {}
+    FinanceRecord(long long income = 0, long long expense = 0)
+        : income_cents(income), expense_cents(expense) {}
 };
 
 class FinanceManager {
 public:
     FinanceManager();
+    // 之后在事务期间对本模块文件的修改都经由 journal 提交
+    void attach_journal(Journal &journal);
 
     void add_income(double amount);
     void add_expense(double amount);
@@ -22,5 +26,10 @@ public:
     void generate_report();
 
 private:
-    MemoryRiver<FinanceRecord, 3> finance_file;  // info1: 总收入, info2: 总支出, info3: 记录数
+    MemoryRiver<FinanceRecord, 2> finance_file;  // info1: 格式标记, info2: 记录数
+
+    void upgrade_legacy_file();
+    void append(long long income_cents, long long expense_cents);
+    // 第 i 笔交易后的累计值，i = 0 时为零
+    FinanceRecord total_after(int i);
 };
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstring>
+#include <string>
+
+// 定长字符串键：最多 N 个字符，其余字节补零，可以直接按字节写入文件
+template<int N>
+struct FixedString {
+    char str[N + 1];
+
+    FixedString() {
+        std::memset(str, 0, sizeof(str));
+    }
+
+    FixedString(const char *s) {
+        std::memset(str, 0, sizeof(str));
+        std::size_t len = std::strlen(s);
+        std::memcpy(str, s, len < N ? len : N);
+    }
+
+    FixedString(const std::string &s) : FixedString(s.c_str()) {}
+
+    int compare(const FixedString &other) const {
+        return std::strcmp(str, other.str);
+    }
+
+    bool operator==(const FixedString &other) const { return compare(other) == 0; }
+    bool operator!=(const FixedString &other) const { return compare(other) != 0; }
+    bool operator<(const FixedString &other) const { return compare(other) < 0; }
+    bool operator>(const FixedString &other) const { return compare(other) > 0; }
+    bool operator<=(const FixedString &other) const { return compare(other) <= 0; }
+    bool operator>=(const FixedString &other) const { return compare(other) >= 0; }
+
+    bool empty() const { return str[0] == '\0'; }
+    std::string to_string() const { return std::string(str); }
+
+    // FNV-1a
+    unsigned hash() const {
+        unsigned h = 2166136261u;
+        for (const char *p = str; *p; ++p) {
+            h ^= static_cast<unsigned char>(*p);
+            h *= 16777619u;
+        }
+        return h;
+    }
+};
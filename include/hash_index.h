@@ -0,0 +1,257 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+#include "MemoryRiver.h"
+
+// 持久化的可扩展哈希索引：Key -> Value，键唯一。
+// Key 需提供 unsigned hash() const 与 operator==，Key / Value 须能按字节写入文件。
+// 文件由等长的页组成：桶页存放记录；目录页的首个 int 是下一目录页的位置，其余为桶页位置。
+// 查找只读一个目录项和一个桶页；桶满时分裂，必要时目录加倍。删除不合并桶。
+template<class Key, class Value>
+class HashIndex {
+public:
+    explicit HashIndex(const std::string &file_name) : file(file_name) {}
+
+    // 清空并重建为只有一个空桶的索引
+    void initialise() {
+        file.initialise();
+        dir_pages.clear();
+
+        Bucket bucket;
+        blank(bucket);
+        int bucket_pos = file.write(bucket);
+
+        Bucket dir_page;
+        blank(dir_page);
+        int dir_pos = file.write(dir_page);
+        dir_pages.push_back(dir_pos);
+        set_dir(0, bucket_pos);
+
+        file.write_info(0, 1);
+        file.write_info(dir_pos, 2);
+        file.write_info(0, 3);
+        loaded = true;
+    }
+
+    // 重建结束时调用：内容先落盘，再写入完整标记并落盘
+    void mark_complete() {
+        file.sync();
+        file.write_info(kIndexComplete, 4);
+        file.sync();
+    }
+
+    // 文件带有完整标记且目录存在；重建中途崩溃留下的文件没有标记
+    bool complete() {
+        int mark = 0, dir_pos = 0;
+        file.get_info(mark, 4);
+        file.get_info(dir_pos, 2);
+        return mark == kIndexComplete && dir_pos != 0;
+    }
+
+    void set_journal(Journal *journal) { file.set_journal(journal); }
+
+    bool find(const Key &key, Value &value) {
+        Bucket bucket;
+        if (locate(key, bucket) < 0) return false;
+        int slot = search(bucket, key);
+        if (slot < 0) return false;
+        value = bucket.entries[slot].value;
+        return true;
+    }
+
+    // 键已存在时返回 false
+    bool insert(const Key &key, const Value &value) {
+        while (true) {
+            Bucket bucket;
+            int pos = locate(key, bucket);
+            if (pos < 0 || search(bucket, key) >= 0) return false;
+            if (bucket.count < kCapacity) {
+                blank(bucket.entries[bucket.count]);
+                bucket.entries[bucket.count].key = key;
+                bucket.entries[bucket.count].value = value;
+                ++bucket.count;
+                write_bucket(bucket, pos);
+                int n = 0;
+                file.get_info(n, 3);
+                file.write_info(n + 1, 3);
+                return true;
+            }
+            if (!split(pos, bucket, key.hash())) return false;
+        }
+    }
+
+    // 修改已有键对应的值，键不存在时返回 false
+    bool update(const Key &key, const Value &value) {
+        Bucket bucket;
+        int pos = locate(key, bucket);
+        if (pos < 0) return false;
+        int slot = search(bucket, key);
+        if (slot < 0) return false;
+        bucket.entries[slot].value = value;
+        write_bucket(bucket, pos);
+        return true;
+    }
+
+    bool erase(const Key &key) {
+        Bucket bucket;
+        int pos = locate(key, bucket);
+        if (pos < 0) return false;
+        int slot = search(bucket, key);
+        if (slot < 0) return false;
+        bucket.entries[slot] = bucket.entries[bucket.count - 1];
+        --bucket.count;
+        write_bucket(bucket, pos);
+        int n = 0;
+        file.get_info(n, 3);
+        file.write_info(n - 1, 3);
+        return true;
+    }
+
+    int size() {
+        if (!load_directory()) return 0;
+        int n = 0;
+        file.get_info(n, 3);
+        return n;
+    }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+    };
+
+    static const int kPageBytes = 4096;
+    static const int kCapacity =
+        (kPageBytes - 2 * static_cast<int>(sizeof(int))) / static_cast<int>(sizeof(Entry));
+    static const int kMaxDepth = 30;
+
+    struct Bucket {
+        int local_depth;
+        int count;
+        Entry entries[kCapacity];
+    };
+
+    static const int kDirFanout = static_cast<int>(sizeof(Bucket) / sizeof(int)) - 1;
+
+    MemoryRiver<Bucket, 4> file;  // info1: 全局深度, info2: 首个目录页位置, info3: 记录数, info4: 完整标记
+    std::vector<int> dir_pages;    // 目录页位置，首次访问时沿链表读入
+    bool loaded = false;
+
+    // 写入文件的页和记录先清零，未用的槽位和填充字节不会把内存中的残留写进文件
+    template<class T>
+    static void blank(T &object) {
+        std::memset(static_cast<void *>(&object), 0, sizeof(T));
+    }
+
+    // 文件中还没有目录（未初始化或文件头损坏）时返回 false，不改动文件；
+    // 此时 complete() 也为假，由调用方重建索引
+    bool load_directory() {
+        if (loaded) return true;
+        int pos = 0;
+        file.get_info(pos, 2);
+        if (pos == 0) return false;
+        dir_pages.clear();
+        while (pos != 0) {
+            dir_pages.push_back(pos);
+            file.read_bytes(&pos, pos, sizeof(int));
+        }
+        loaded = true;
+        return true;
+    }
+
+    int dir_entry_pos(int i) {
+        return dir_pages[i / kDirFanout] + (1 + i % kDirFanout) * static_cast<int>(sizeof(int));
+    }
+
+    int get_dir(int i) {
+        int pos = 0;
+        file.read_bytes(&pos, dir_entry_pos(i), sizeof(int));
+        return pos;
+    }
+
+    void set_dir(int i, int pos) {
+        file.update_bytes(&pos, dir_entry_pos(i), sizeof(int));
+    }
+
+    // 只读桶头和有效记录
+    void read_bucket(Bucket &bucket, int pos) {
+        file.read_bytes(&bucket, pos, entries_offset(0));
+        file.read_bytes(bucket.entries, pos + entries_offset(0), bucket.count * sizeof(Entry));
+    }
+
+    void write_bucket(Bucket &bucket, int pos) {
+        file.update_bytes(&bucket, pos, entries_offset(bucket.count));
+    }
+
+    static int entries_offset(int count) {
+        return static_cast<int>(offsetof(Bucket, entries) + count * sizeof(Entry));
+    }
+
+    // 返回 key 所在桶的位置并读入 bucket；索引没有目录时返回 -1
+    int locate(const Key &key, Bucket &bucket) {
+        if (!load_directory()) return -1;
+        int depth = 0;
+        file.get_info(depth, 1);
+        int pos = get_dir(static_cast<int>(key.hash() & ((1u << depth) - 1)));
+        read_bucket(bucket, pos);
+        return pos;
+    }
+
+    static int search(const Bucket &bucket, const Key &key) {
+        for (int i = 0; i < bucket.count; ++i) {
+            if (bucket.entries[i].key == key) return i;
+        }
+        return -1;
+    }
+
+    // 目录项数翻倍：新的后半部分复制前半部分
+    bool double_directory(int &depth) {
+        if (depth >= kMaxDepth) return false;
+        int old_size = 1 << depth;
+        while (static_cast<int>(dir_pages.size()) * kDirFanout < old_size * 2) {
+            Bucket page;
+            blank(page);
+            int pos = file.write(page);
+            file.update_bytes(&pos, dir_pages.back(), sizeof(int));
+            dir_pages.push_back(pos);
+        }
+        for (int i = 0; i < old_size; ++i) set_dir(old_size + i, get_dir(i));
+        ++depth;
+        file.write_info(depth, 1);
+        return true;
+    }
+
+    // 把位于 pos 的满桶按第 local_depth 位拆成两个，hash 为落在该桶中的任一键的哈希值
+    bool split(int pos, Bucket &bucket, unsigned hash) {
+        int depth = 0;
+        file.get_info(depth, 1);
+        if (bucket.local_depth == depth && !double_directory(depth)) return false;
+
+        int bit = bucket.local_depth;
+        Bucket sibling;
+        blank(sibling);
+        sibling.local_depth = bit + 1;
+        int kept = 0;
+        for (int i = 0; i < bucket.count; ++i) {
+            if ((bucket.entries[i].key.hash() >> bit) & 1u) {
+                sibling.entries[sibling.count++] = bucket.entries[i];
+            } else {
+                bucket.entries[kept++] = bucket.entries[i];
+            }
+        }
+        bucket.count = kept;
+        bucket.local_depth = bit + 1;
+
+        int sibling_pos = file.write(sibling);
+        write_bucket(bucket, pos);
+
+        unsigned low = hash & ((1u << bit) - 1);
+        for (int i = static_cast<int>(low); i < (1 << depth); i += (1 << bit)) {
+            if ((i >> bit) & 1) set_dir(i, sibling_pos);
+        }
+        return true;
+    }
+};
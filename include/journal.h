@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// 参与事务的文件：事务期间的修改暂存在内存中，由 Journal 在提交时统一落盘
+class JournalFile {
+public:
+    virtual ~JournalFile() {}
+
+    // 把暂存的修改按日志格式追加到 out
+    virtual void serialize_pending(std::string &out) = 0;
+    // 日志落盘后，把暂存的修改写入文件本身
+    virtual void apply_pending() = 0;
+    // 写回缓存并让文件内容落到磁盘
+    virtual void sync() = 0;
+};
+
+// 预写日志：把一条指令对多个文件的修改合成一个原子事务。
+// 提交时先把全部修改写入日志文件并同步一次，再写入各数据文件；
+// 启动时重放日志中完整提交的事务，未提交的部分直接丢弃。
+// 日志超过一定长度时做检查点：同步全部数据文件后清空日志。
+class Journal {
+public:
+    explicit Journal(const std::string &file_name = "journal.dat");
+    ~Journal();
+
+    void attach(JournalFile *file);
+    void enlist(JournalFile *file);
+
+    void begin();
+    void commit();
+    bool active() const { return in_txn; }
+
+    // 同步全部挂接的文件（包括不经日志直接写入的）后清空日志
+    void checkpoint();
+    // 关闭后提交不再同步日志，只保证进程崩溃时的原子性
+    void set_sync(bool on) { sync_on_commit = on; }
+
+    static void encode_write(std::string &out, const std::string &name,
+                             long pos, const char *data, int len);
+    static void encode_truncate(std::string &out, const std::string &name, long size);
+
+private:
+    std::string file_name;
+    int fd;
+    bool in_txn;
+    bool sync_on_commit;
+    long written;
+    std::vector<JournalFile *> files;     // 所有挂接的文件
+    std::vector<JournalFile *> enlisted;  // 当前事务中有修改的文件
+    std::vector<JournalFile *> dirty;     // 上次检查点之后提交过修改的文件
+
+    void recover();
+    // 同步 to_sync 中的文件后清空日志
+    void truncate_log(const std::vector<JournalFile *> &to_sync);
+};
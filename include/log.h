@@ -5,7 +5,11 @@
 #include <cstring>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 #include "MemoryRiver.h"
+#include "fixed_string.h"
+#include "bplus_tree.h"
+#include "posting_file.h"
 
 struct LogEntry {
     char user[31];
@@ -19,16 +23,108 @@ struct LogEntry {
     }
 };
 
+// log.seg 中一个归档段的段头，其后紧跟 comp_len 字节的压缩数据。
+// 解压后依次为：字典（段内出现的用户名与类型）、每条记录的用户编号、类型编号和指令原文，
+// 整数均为变长编码。
+struct LogSegmentHeader {
+    int magic;
+    int records;
+    int raw_len;
+    int comp_len;
+};
+
+// 清单 log.mft 中一个归档段的描述。归档段按编号顺序写入 log.seg 后不再修改。
+// 按用户或类型筛选时由倒排索引直接给出命中记录的序号，不需要逐段判断。
+struct LogSegmentInfo {
+    int offset;          // 段头在 log.seg 中的位置
+    int first;           // 段内首条记录的序号（0_base）
+    int records;
+};
+
+// log 指令的筛选条件；记录序号从 1 开始，区间为闭区间
+struct LogFilter {
+    std::string user;     // 为空时不限用户
+    std::string type;     // 为空时不限类型，否则为 SYS 或 FIN
+    int from = 1;
+    int to = 0x7fffffff;
+    int last = -1;        // 不小于 0 时只看最后 last 条，忽略 from / to
+};
+
+// 某个用户名下 SYS / FIN 日志的条数，以及该用户全部日志在 log.idx 中的倒排表
+struct EmployeeCounter {
+    int sys;
+    int fin;
+    PostingList postings;
+};
+
+class LogManager;
+
+// 按写入顺序流式读出全部日志：先按清单逐段解压归档段，再读 log.dat 中尚未归档的记录。
+// 记录按全局序号（0_base）编号；seek 之后 next 从指定序号继续读。
+// 同一时刻只有一个归档段在内存中。
+class LogReader {
+public:
+    explicit LogReader(LogManager &manager);
+    bool next(LogEntry &e);
+    void seek(int ordinal);
+
+private:
+    LogManager &manager;
+    int segment_index = 0;           // 下一个归档段的编号
+    int segments;
+    int archived;                    // 归档段中的记录总数
+    std::string raw;                 // 当前归档段解压后的内容
+    size_t cursor = 0;
+    int records_left = 0;            // 当前归档段中尚未读出的记录数
+    std::vector<std::string> dict;   // 当前归档段的字典
+    int active_start;                // log.dat 中首条未归档记录的位置（0_base）
+    MemoryRiver<LogEntry>::Cursor active;  // 按块读出 log.dat 中未归档的记录
+    int next_ordinal = 0;
+    int loaded = -1;                 // 当前在内存中的归档段编号
+
+    static int active_info(LogManager &manager, int n);
+    bool load_segment();
+    bool decode(LogEntry *e);
+};
+
+// 日志记录先追加到内存缓冲区，攒够一批或距上次写入超过一定时间后一次写入 log.dat；
+// 读取日志前和退出时也会写入。开启 flush_each_command 时每条指令结束都写入，
+// 日志与指令的其他修改在同一事务中提交。
 class LogManager {
 public:
     LogManager();
+    // 之后在事务期间对本模块文件的修改都经由 journal 提交
+    void attach_journal(Journal &journal);
 
     void record_sys(const std::string &user, const std::string &action);
     void record_fin(const std::string &user, const std::string &action);
 
-    void show_log();
+    void show_log(const LogFilter &filter = LogFilter());
     void generate_employee_report();
 
+    // 指令结束时调用：按设置或时间阈值决定是否写入缓冲区
+    void end_command();
+    void flush();
+    void set_flush_each_command(bool on) { flush_each_command = on; }
+
 private:
-    MemoryRiver<LogEntry> file;
+    friend class LogReader;
+
+    // log.dat 中前 info2 条记录已归档到 log.seg；剩余的不足一段时搬到文件开头，info2 归零
+    MemoryRiver<LogEntry> file;                  // info1: 记录数, info2: 已归档的记录数
+    MemoryRiver<LogSegmentHeader, 3> archive;    // info1: 段数, info2: 记录数, info3: 文件末尾位置
+    MemoryRiver<LogSegmentInfo, 2> manifest;     // info1: 段数, info2: 归档记录数；第 i 项描述第 i 段
+    BPlusTree<FixedString<30>, EmployeeCounter> employee_index;  // 用户名 -> 日志条数与倒排表，随日志一起写入
+    PostingFile postings;  // 各用户的倒排表与 0 号（SYS）、1 号（FIN）全局表，值为 序号 * 2 + 是否 FIN
+    std::vector<LogEntry> buffer;
+    bool flush_each_command = false;
+    std::chrono::steady_clock::time_point last_flush;
+
+    void append(const std::string &user, const char *type, const std::string &action);
+    void seal_segment();
+    void rebuild_manifest();
+    bool segment_info(int i, LogSegmentInfo &info);
+    void rebuild_log_indexes();
+    void add_record(EmployeeCounter &counter, int value);
+    int record_count();
 };
@@ -0,0 +1,77 @@
+#pragma once
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// 容量有限的 LRU 缓存：Key -> Value，超出容量时淘汰最久未使用的项。
+// Key 需能作为 std::unordered_map 的键。同时统计命中与未命中次数，便于按容量评估收益。
+template<class Key, class Value>
+class LruCache {
+public:
+    explicit LruCache(int capacity) : capacity(capacity < 0 ? 0 : capacity) {}
+
+    // 命中时把值复制到 value，并把该项移到表头
+    bool get(const Key &key, Value &value) {
+        auto it = index.find(key);
+        if (it == index.end()) {
+            ++miss_count;
+            return false;
+        }
+        ++hit_count;
+        items.splice(items.begin(), items, it->second);
+        value = it->second->second;
+        return true;
+    }
+
+    // 插入或覆盖，该项成为最近使用的项
+    void put(const Key &key, const Value &value) {
+        if (capacity == 0) return;
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = value;
+            items.splice(items.begin(), items, it->second);
+            return;
+        }
+        items.push_front(std::make_pair(key, value));
+        index[key] = items.begin();
+        trim();
+    }
+
+    void erase(const Key &key) {
+        auto it = index.find(key);
+        if (it == index.end()) return;
+        items.erase(it->second);
+        index.erase(it);
+    }
+
+    void clear() {
+        items.clear();
+        index.clear();
+    }
+
+    void set_capacity(int n) {
+        capacity = n < 0 ? 0 : n;
+        trim();
+    }
+
+    int size() const { return static_cast<int>(items.size()); }
+    int max_size() const { return capacity; }
+    long long hits() const { return hit_count; }
+    long long misses() const { return miss_count; }
+
+private:
+    typedef std::pair<Key, Value> Item;
+
+    int capacity;
+    std::list<Item> items;  // 表头为最近使用的项
+    std::unordered_map<Key, typename std::list<Item>::iterator> index;
+    long long hit_count = 0;
+    long long miss_count = 0;
+
+    void trim() {
+        while (static_cast<int>(items.size()) > capacity) {
+            index.erase(items.back().first);
+            items.pop_back();
+        }
+    }
+};
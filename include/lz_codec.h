@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// 简单的 LZ77 字节压缩，不依赖外部库。
+// 输出为若干序列：标记字节（高 4 位为字面量长度，低 4 位为匹配长度 - 4，
+// 取 15 时后续跟 255 累加的扩展长度）、字面量、2 字节的回溯距离。
+// 最后一个序列只有字面量。
+void lz_compress(const char *src, size_t len, std::string &out);
+
+// 解压到 out，要求解压后恰好为 raw_len 字节；数据损坏时返回 false
+bool lz_decompress(const char *src, size_t len, size_t raw_len, std::string &out);
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// 两位小数的定点输出：output() << Fixed2(x) 与 printf("%.2f", x) 结果一致
+struct Fixed2 {
+    double value;
+    explicit Fixed2(double v) : value(v) {}
+};
+
+// 标准输出的缓冲层：格式化结果直接写进一块复用的大缓冲区，
+// 缓冲区满、显式 flush 或程序结束时才调用一次 write。
+// 整数与 Fixed2 自行格式化，不经过 iostream 的 locale 机制。
+class Output {
+public:
+    Output();
+    ~Output();
+
+    Output &operator<<(const char *s);
+    Output &operator<<(const std::string &s);
+    Output &operator<<(char c);
+    Output &operator<<(int v);
+    Output &operator<<(long long v);
+    Output &operator<<(Fixed2 v);
+
+    void write(const char *s, size_t n);
+    void flush();
+
+private:
+    static const size_t kCapacity = 1 << 16;
+    char *buffer;
+    size_t used = 0;
+
+    Output(const Output &) = delete;
+    Output &operator=(const Output &) = delete;
+};
+
+// 进程内唯一的输出实例，所有面向用户的输出都经由它写出
+Output &output();
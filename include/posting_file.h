@@ -0,0 +1,111 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+#include "MemoryRiver.h"
+
+// 一个倒排表：由定长块串成的单链表，只在末尾追加。空表的首块、末块位置都为 0。
+// 表本身只是两个位置，由调用方与其他数据（如用户的日志计数）存放在一起。
+struct PostingList {
+    int first = 0;
+    int last = 0;
+};
+
+// 持久化的倒排表文件：所有表的块都在同一个文件中，值为非负整数，追加时须不减。
+// 追加只改动末块的计数和一个值（满块时再写一个新块），读取时沿链表顺序访问。
+// 文件头另存两个全局表（编号 0、1），供按类型筛选时使用。
+class PostingFile {
+public:
+    explicit PostingFile(const std::string &file_name) : file(file_name) {}
+
+    // 清空为只有文件头的空文件
+    void initialise() {
+        file.initialise();
+        file.write_info(kPostingMagic, 1);
+    }
+
+    void set_journal(Journal *journal) { file.set_journal(journal); }
+
+    // 重建结束时调用：内容先落盘，再写入完整标记并落盘
+    void mark_complete() {
+        file.sync();
+        file.write_info(kIndexComplete, 6);
+        file.sync();
+    }
+
+    // 文件带有本格式的标识和完整标记；旧格式或重建中途崩溃留下的文件都不算
+    bool complete() {
+        int magic = 0, mark = 0;
+        file.get_info(magic, 1);
+        file.get_info(mark, 6);
+        return magic == kPostingMagic && mark == kIndexComplete;
+    }
+
+    void append(PostingList &list, int value) {
+        if (list.last != 0) {
+            int count = 0;
+            file.read_bytes(&count, list.last + offsetof(Chunk, count), sizeof(int));
+            if (count < kChunkValues) {
+                file.update_bytes(&value, list.last + value_offset(count), sizeof(int));
+                ++count;
+                file.update_bytes(&count, list.last + offsetof(Chunk, count), sizeof(int));
+                return;
+            }
+        }
+        Chunk chunk;
+        chunk.next = 0;
+        chunk.count = 1;
+        chunk.values[0] = value;
+        for (int i = 1; i < kChunkValues; ++i) chunk.values[i] = 0;
+        int pos = file.write(chunk);
+        if (list.last != 0) file.update_bytes(&pos, list.last + offsetof(Chunk, next), sizeof(int));
+        else list.first = pos;
+        list.last = pos;
+    }
+
+    // 文件头中的第 id 个全局表（id 为 0 或 1）
+    PostingList global(int id) {
+        PostingList list;
+        file.get_info(list.first, 2 + 2 * id);
+        file.get_info(list.last, 3 + 2 * id);
+        return list;
+    }
+
+    void append_global(int id, int value) {
+        PostingList list = global(id);
+        append(list, value);
+        file.write_info(list.first, 2 + 2 * id);
+        file.write_info(list.last, 3 + 2 * id);
+    }
+
+    // 按升序对 list 中落在 [lo, hi] 内的值调用 f(value)；整块都小于 lo 的块只读块尾
+    template<class F>
+    void for_range(const PostingList &list, int lo, int hi, F f) {
+        Chunk chunk;
+        for (int pos = list.first; pos != 0; pos = chunk.next) {
+            file.read(chunk, pos);
+            if (chunk.count == 0 || chunk.values[chunk.count - 1] < lo) continue;
+            for (int i = 0; i < chunk.count; ++i) {
+                if (chunk.values[i] > hi) return;
+                if (chunk.values[i] >= lo) f(chunk.values[i]);
+            }
+        }
+    }
+
+private:
+    static const int kPostingMagic = 0x5453504C;  // "LPST"
+    static const int kChunkValues = 62;          // 一块 256 字节
+
+    struct Chunk {
+        int next;   // 下一块的位置，0 表示链表结束
+        int count;
+        int values[kChunkValues];
+    };
+
+    static int value_offset(int i) {
+        return static_cast<int>(offsetof(Chunk, values) + i * sizeof(int));
+    }
+
+    // info1: 格式标识, info2/3: 0 号表的首块/末块, info4/5: 1 号表的首块/末块, info6: 完整标记
+    MemoryRiver<Chunk, 6> file;
+};
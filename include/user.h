@@ -2,6 +2,8 @@
 #include <string>
 
 #include "MemoryRiver.h"
+#include "fixed_string.h"
+#include "hash_index.h"
 
 struct User {
     char user_id[31];
@@ -18,6 +20,8 @@ class AccountManager {
 public:
     AccountManager();
     void initialize();
+    // 之后在事务期间对本模块文件的修改都经由 journal 提交
+    void attach_journal(Journal &journal);
 
     bool register_user(const std::string &user_id,
                        const std::string &password,
@@ -44,9 +48,16 @@ public:
     bool delete_user(const std::string &user_id);
 
 private:
-    MemoryRiver<User, 1> user_file;
+    typedef FixedString<30> UserKey;
+
+    MemoryRiver<User, 2, 2> user_file;  // info1: 槽位数, info2: 空闲链表表头
+    HashIndex<UserKey, int> user_index;  // user_id -> users.dat 中的位置
 
     bool find_user(const std::string &user_id, User &user, int &index);
     bool validate_string(const std::string &str, bool allow_quotes);
     void rebuild_users_file();
+    void repair_users_file();
+    void upgrade_users_file();
+    void rebuild_user_index();
+    int append_user(User &user);
 };
\ No newline at end of file
@@ -1,12 +1,13 @@
 #include "include/application.h"
+#include "include/output.h"
 
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <iomanip>
 #include <algorithm>
-#include <regex>
 #include <cctype>
+#include <cstring>
 #include <limits>
 #include <set>
 
@@ -30,6 +31,52 @@ static bool parse_int_strict(const std::string& s, int& out) {
     }
 }
 
+static bool is_ascii_visible(const char* p, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        unsigned char ch = static_cast<unsigned char>(p[i]);
+        if (ch > 127 || !std::isprint(ch)) return false;
+    }
+    return true;
+}
+
+// 解析一个 show 条件：-ISBN=[ISBN]、-name="[BookName]"、-author="[Author]" 或 -keyword="[Keyword]"。
+// 同一种条件重复出现时返回 false
+static bool parse_show_criterion(const std::string& arg, BookFilter& filter) {
+    std::size_t eq = arg.find('=');
+    if (arg.empty() || arg[0] != '-' || eq == std::string::npos || eq + 1 == arg.size()) return false;
+    const char* key = arg.data() + 1;
+    std::size_t key_len = eq - 1;
+    const char* value = arg.data() + eq + 1;
+    std::size_t len = arg.size() - eq - 1;
+    auto key_is = [&](const char* name) {
+        return std::strlen(name) == key_len && std::memcmp(key, name, key_len) == 0;
+    };
+
+    if (key_is("ISBN")) {
+        // 最大长度 20
+        if (len > 20 || !is_ascii_visible(value, len) || !filter.isbn.empty()) return false;
+        filter.isbn.assign(value, len);
+        return true;
+    }
+
+    std::string* field = nullptr;
+    if (key_is("name")) field = &filter.name;
+    else if (key_is("author")) field = &filter.author;
+    else if (key_is("keyword")) field = &filter.keyword;
+    if (field == nullptr || !field->empty()) return false;
+
+    // 必须有外层引号，引号内不能再出现双引号
+    if (len < 2 || value[0] != '"' || value[len - 1] != '"') return false;
+    ++value;
+    len -= 2;
+    if (len == 0 || len > 60) return false;
+    if (std::memchr(value, '"', len) != nullptr || !is_ascii_visible(value, len)) return false;
+    // show -keyword 只允许单个关键词
+    if (field == &filter.keyword && std::memchr(value, '|', len) != nullptr) return false;
+    field->assign(value, len);
+    return true;
+}
+
 static bool parse_price_strict(const std::string& s, double& out) {
     if (s.empty()) return false;
     if (s.size() > 13) return false;
@@ -72,52 +119,53 @@ static bool parse_price_strict(const std::string& s, double& out) {
 
 
 Application::Application()
-    : account_manager(), book_manager(), finance_manager(), log_manager() {
+    : journal(), account_manager(), book_manager(), finance_manager(), log_manager() {
     account_manager.initialize();
+    account_manager.attach_journal(journal);
+    book_manager.attach_journal(journal);
+    finance_manager.attach_journal(journal);
+    log_manager.attach_journal(journal);
+    // 启动时的迁移与重建不经过日志，开始处理命令前先全部落盘
+    journal.checkpoint();
+}
+
+Application::~Application() {
+    journal.begin();
+    log_manager.flush();
+    journal.commit();
+    journal.checkpoint();
 }
 
 void Application::run() {
     std::string line;
-    while (std::getline(std::cin, line)) {
+    Command cmd;
+    while (true) {
+        // 已读入的输入处理完、下一次读取可能阻塞时，先把积攒的输出写出
+        if (std::cin.rdbuf()->in_avail() <= 0) output().flush();
+        if (!std::getline(std::cin, line)) break;
         line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
 
-        bool all_space = true;
-        for (unsigned char ch : line) {
-            if (ch != ' ') {
-                all_space = false;
-                break;
-            } // 只认空格
-        }
-        if (all_space) continue;
-
-        bool bad = false;
-        for (unsigned char ch : line) {
-            if (ch == ' ') continue;
-            if (ch > 127 || ch < 32) {
-                bad = true;
-                break;
-            }
-            // 不可见字符非法；任何非空格空白符非法
-            if (!std::isprint(ch) || (std::isspace(ch) && ch != ' ')) {
-                bad = true;
-                break;
-            }
-        }
-        if (bad) {
-            std::cout << "Invalid\n";
+        // 只含空格的行直接跳过；不可见字符、非空格空白符非法
+        LineStatus status = parser.parse(line, cmd);
+        if (status == LineStatus::Blank) continue;
+        if (status == LineStatus::Bad) {
+            output() << "Invalid\n";
             continue;
         }
 
-        Command cmd = parser.parse(line);
-
         if (cmd.type == CommandType::Quit || cmd.type == CommandType::Exit) {
-            if (!cmd.args.empty()) std::cout << "Invalid\n";
+            if (!cmd.args.empty()) output() << "Invalid\n";
             else break;
             continue;
         }
 
+        // 一条指令对各文件的修改作为一个事务提交
+        journal.begin();
         handle_command(cmd, line);
+        log_manager.end_command();
+        journal.commit();
     }
+    output().flush();
 }
 
 void Application::handle_command(const Command& cmd, const std::string& raw_line) {
@@ -134,11 +182,11 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
     case CommandType::Register:
         if (cmd.args.size() == 3) {
             bool ok = account_manager.register_user(cmd.args[0], cmd.args[1], cmd.args[2]);
-            if (!ok) std::cout << "Invalid\n";
+            if (!ok) output() << "Invalid\n";
             else log_manager.record_sys("GUEST", raw_line);
         }
         else {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
         }
         break;
 
@@ -159,18 +207,18 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
                 log_manager.record_sys(user.user_id, raw_line);
             }
             else {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
             }
         }
         else {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
         }
         break;
     }
 
     case CommandType::Logout:
         if (privilege < 1 || sessions.empty()) {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
         }
         else {
             std::string who = current_user();
@@ -182,7 +230,7 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
 
     case CommandType::Passwd:
         if (privilege < 1) {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
             break;
         }
         if (cmd.args.size() == 2 || cmd.args.size() == 3) {
@@ -201,11 +249,11 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
 
             bool ok = account_manager.passwd(user_id, current_password, new_password,
                                              has_current_password, privilege);
-            if (!ok) std::cout << "Invalid\n";
+            if (!ok) output() << "Invalid\n";
             else log_manager.record_sys(current_user(), raw_line);
         }
         else {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
         }
         break;
 
@@ -215,28 +263,28 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
             std::string password = cmd.args[1];
             int user_privilege = 0;
             if (!parse_int_strict(cmd.args[2], user_privilege)) {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
                 break;
             }
 
             std::string username = cmd.args[3];
 
             if (user_privilege != 0 && user_privilege != 1 && user_privilege != 3 && user_privilege != 7) {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
                 break;
             }
 
             if (privilege <= user_privilege) {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
                 break;
             }
 
             bool ok = account_manager.useradd(user_id, password, user_privilege, username, privilege);
-            if (!ok) std::cout << "Invalid\n";
+            if (!ok) output() << "Invalid\n";
             else log_manager.record_sys(current_user(), raw_line);
         }
         else {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
         }
         break;
 
@@ -244,26 +292,26 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
         if (cmd.args.size() == 1 && privilege == 7) {
             std::string user_id = cmd.args[0];
             if (sessions.is_user_logged_in(user_id)) {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
                 break;
             }
             bool ok = account_manager.delete_user(user_id);
-            if (!ok) std::cout << "Invalid\n";
+            if (!ok) output() << "Invalid\n";
             else log_manager.record_sys(current_user(), raw_line);
         }
         else {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
         }
         break;
 
     case CommandType::Show:
         if (privilege < 1) {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
             break;
         }
-        // show 指令只允许 0 或 1 个附加参数
-        if (cmd.args.size() > 1) {
-            std::cout << "Invalid\n";
+        // 每种条件至多出现一次，因此最多 4 个附加参数
+        if (cmd.args.size() > 4) {
+            output() << "Invalid\n";
             break;
         }
         if (cmd.args.empty()) {
@@ -271,7 +319,7 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
             log_manager.record_sys(current_user(), raw_line);
         }
         else {
-            show_books_with_criteria(cmd.args[0]);
+            show_books_with_criteria(cmd.args);
             log_manager.record_sys(current_user(), raw_line);
         }
         break;
@@ -282,7 +330,7 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
             std::string isbn = cmd.args[0];
             int quantity = 0;
             if (!parse_int_strict(cmd.args[1], quantity)) {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
                 break;
             }
 
@@ -290,14 +338,14 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
             double total_cost = 0.0;
 
             if (quantity <= 0) {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
                 break;
             }
 
             bool ok = book_manager.buy(isbn, quantity, total_cost);
             if (ok) {
                 finance_manager.add_income(total_cost);
-                std::cout << std::fixed << std::setprecision(2) << total_cost << '\n';
+                output() << Fixed2(total_cost) << '\n';
 
                 std::ostringstream oss;
                 oss << "BUY isbn=" << isbn << " qty=" << quantity
@@ -307,11 +355,11 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
                 log_manager.record_sys(current_user(), raw_line);
             }
             else {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
             }
         }
         else {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
         }
         break;
 
@@ -319,21 +367,21 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
         if (cmd.args.size() == 1 && privilege >= 3) {
             std::string isbn = cmd.args[0];
             bool ok = book_manager.select(isbn, sessions.top());
-            if (!ok) std::cout << "Invalid\n";
+            if (!ok) output() << "Invalid\n";
             else log_manager.record_sys(current_user(), raw_line);
         }
         else {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
         }
         break;
 
     case CommandType::Modify: {
         if (privilege < 3 || sessions.empty() || cmd.args.empty()) {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
             break;
         }
         if (sessions.top().selected_pos == -1) {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
             break;
         }
 
@@ -415,13 +463,13 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
         }
 
         if (bad) {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
             break;
         }
 
         bool ok = book_manager.modify(sessions.top().selected_pos, modifications);
         if (!ok) {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
         }
         else {
             log_manager.record_sys(sessions.top().user_id, raw_line);
@@ -433,7 +481,7 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
     case CommandType::Import:
         if (cmd.args.size() == 2 && !sessions.empty() && privilege >= 3) {
             if (sessions.top().selected_pos == -1) {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
                 break;
             }
 
@@ -441,17 +489,17 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
             double total_cost = 0.0;
 
             if (!parse_int_strict(cmd.args[0], quantity)) {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
                 break;
             }
             if (!parse_price_strict(cmd.args[1], total_cost)) {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
                 break;
             }
 
 
             if (quantity <= 0 || total_cost <= 0) {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
                 break;
             }
 
@@ -468,11 +516,11 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
                 log_manager.record_sys(current_user(), raw_line);
             }
             else {
-                std::cout << "Invalid\n";
+                output() << "Invalid\n";
             }
         }
         else {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
         }
         break;
 
@@ -489,18 +537,18 @@ void Application::handle_command(const Command& cmd, const std::string& raw_line
         break;
 
     case CommandType::Log:
-        handle_log();
+        handle_log(cmd.args);
         break;
 
     default:
-        std::cout << "Invalid\n";
+        output() << "Invalid\n";
         break;
     }
 }
 
 void Application::handle_show_finance(const std::vector<std::string>& args) {
     if (sessions.current_privilege() < 7) {
-        std::cout << "Invalid\n";
+        output() << "Invalid\n";
         return;
     }
 
@@ -510,23 +558,23 @@ void Application::handle_show_finance(const std::vector<std::string>& args) {
     else if (args.size() == 1) {
         int count = 0;
         if (!parse_int_strict(args[0], count)) {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
             return;
         }
         if (count < 0) {
-            std::cout << "Invalid\n";
+            output() << "Invalid\n";
             return;
         }
         finance_manager.show_last_n(count);
     }
     else {
-        std::cout << "Invalid\n";
+        output() << "Invalid\n";
     }
 }
 
 void Application::handle_report_finance() {
     if (sessions.current_privilege() < 7) {
-        std::cout << "Invalid\n";
+        output() << "Invalid\n";
         return;
     }
 
@@ -535,103 +583,77 @@ void Application::handle_report_finance() {
 
 void Application::handle_report_employee() {
     if (sessions.current_privilege() < 7) {
-        std::cout << "Invalid\n";
+        output() << "Invalid\n";
         return;
     }
 
     log_manager.generate_employee_report();
 }
 
-void Application::handle_log() {
+// log [-user=[UserID]] [-type=(SYS|FIN)] [-from=[Index]] [-to=[Index]] | [-last=[Count]]
+// 各选项至多出现一次，-last 不能与 -from / -to 同时使用
+void Application::handle_log(const std::vector<std::string>& args) {
     if (sessions.current_privilege() < 7) {
-        std::cout << "Invalid\n";
-        return;
-    }
-
-    log_manager.show_log();
-}
-
-void Application::show_books_with_criteria(const std::string& criteria) {
-    std::smatch match;
-    std::regex pattern("-(ISBN|name|author|keyword)=(.+)");
-
-    if (!std::regex_match(criteria, match, pattern)) {
-        std::cout << "Invalid\n";
+        output() << "Invalid\n";
         return;
     }
 
-    std::string type = match[1];
-    std::string value = match[2];
-
-    auto is_ascii_visible = [](const std::string& s) -> bool
-    {
-        for (unsigned char ch : s) {
-            if (ch > 127) return false;
-            if (!std::isprint(ch)) return false;
-        }
-        return true;
-    };
-
-    if (type == "name" || type == "author" || type == "keyword") {
-        // 必须有外层引号
-        if (value.size() < 2 || value.front() != '"' || value.back() != '"') {
-            std::cout << "Invalid\n";
+    LogFilter filter;
+    std::set<std::string> seen;
+    for (const std::string& arg : args) {
+        std::size_t eq = arg.find('=');
+        if (arg.size() < 2 || arg[0] != '-' || eq == std::string::npos || eq + 1 == arg.size()) {
+            output() << "Invalid\n";
             return;
         }
-        value = value.substr(1, value.size() - 2);
-
-        // 引号内不能再出现双引号
-        if (value.find('"') != std::string::npos) {
-            std::cout << "Invalid\n";
+        std::string key = arg.substr(1, eq - 1);
+        std::string value = arg.substr(eq + 1);
+        if (!seen.insert(key).second) {
+            output() << "Invalid\n";
             return;
         }
 
-        // 最大长度 60（不含引号）
-        if (value.size() > 60) {
-            std::cout << "Invalid\n";
-            return;
+        bool ok = true;
+        if (key == "user") {
+            ok = value.size() <= 30;
+            filter.user = value;
         }
-
-        // 标准 ASCII 可见字符
-        if (!is_ascii_visible(value)) {
-            std::cout << "Invalid\n";
-            return;
+        else if (key == "type") {
+            ok = value == "SYS" || value == "FIN";
+            filter.type = value;
         }
-
-        // show -keyword 只允许单个关键词
-        if (type == "keyword" && value.find('|') != std::string::npos) {
-            std::cout << "Invalid\n";
+        else if (key == "from") {
+            ok = parse_int_strict(value, filter.from) && filter.from >= 1;
+        }
+        else if (key == "to") {
+            ok = parse_int_strict(value, filter.to) && filter.to >= 1;
+        }
+        else if (key == "last") {
+            ok = parse_int_strict(value, filter.last);
+        }
+        else {
+            ok = false;
+        }
+        if (!ok) {
+            output() << "Invalid\n";
             return;
         }
     }
-
-    if (value.empty()) {
-        std::cout << "Invalid\n";
+    if (seen.count("last") && (seen.count("from") || seen.count("to"))) {
+        output() << "Invalid\n";
         return;
     }
 
-    if (type == "ISBN") {
-        // 最大长度 20
-        if (value.size() > 20) {
-            std::cout << "Invalid\n";
-            return;
-        }
-        if (!is_ascii_visible(value)) {
-            std::cout << "Invalid\n";
+    log_manager.show_log(filter);
+}
+
+void Application::show_books_with_criteria(const std::vector<std::string>& criteria) {
+    BookFilter filter;
+    for (const std::string& arg : criteria) {
+        if (!parse_show_criterion(arg, filter)) {
+            output() << "Invalid\n";
             return;
         }
-        book_manager.show_by_isbn(value);
-    }
-    else if (type == "name") {
-        book_manager.show_by_name(value);
-    }
-    else if (type == "author") {
-        book_manager.show_by_author(value);
-    }
-    else if (type == "keyword") {
-        book_manager.show_by_keyword(value);
-    }
-    else {
-        std::cout << "Invalid\n";
     }
+    book_manager.show_matching(filter);
 }
@@ -1,14 +1,24 @@
 #include "include/book.h"
+#include "include/output.h"
 
-#include <iostream>
 #include <fstream>
+#include <cstdlib>
 #include <cstring>
 #include <algorithm>
 #include <sstream>
-#include <iomanip>
 #include <set>
 #include <string>
 
+// 常用图书缓存的默认容量（本数）
+static const int kBookCacheSize = 1024;
+
+// books.dat 的 info2：区分当前格式与旧版定长 Book 记录（旧版此处是首本书 ISBN 的字符）
+static const int kBookMagic = -0x4B4F4F42;
+
+static long long price_to_cents(double price) {
+    return static_cast<long long>(price * 100 + 0.5);  // 四舍五入
+}
+
 // 价格格式校验：必须有整数部分；可选小数部分；小数位 1~2 位
 // 允许：0, 10, 10.0, 10.00, 0.12
 // 禁止：.12, 01, 01.2, 10., 10.000, -1, +1
@@ -74,18 +84,158 @@ Book::Book(const std::string &i, const std::string &n,
     quantity = q;
 }
 
+BookRecord::BookRecord() {
+    std::memset(static_cast<void *>(this), 0, sizeof(BookRecord));
+}
+
 BookManager::BookManager()
-    : book_file("books.dat") {
+    : book_file("books.dat", RiverMode::Mapped), text_file("books.str", RiverMode::Mapped),
+      isbn_index("isbn.idx"),
+      name_index("name.idx"), author_index("author.idx"), keyword_index("keyword.idx"),
+      book_cache(kBookCacheSize) {
     std::ifstream fin("books.dat", std::ios::binary);
-    bool need_init = false;
+    bool need_init = false, legacy = false;
     if (!fin.good()) {
         need_init = true;
     } else {
         fin.seekg(0, std::ios::end);
         if (fin.tellg() < static_cast<std::streamoff>(sizeof(int))) need_init = true;
+        int header[2] = {0, 0};
+        fin.seekg(0, std::ios::beg);
+        fin.read(reinterpret_cast<char *>(header), sizeof(header));
+        legacy = header[1] != kBookMagic;
+    }
+    fin.close();
+    if (need_init) {
+        book_file.initialise();
+        book_file.write_info(kBookMagic, 2);
+        text_file.initialise();
+    } else if (legacy) {
+        upgrade_legacy_file();
+    }
+
+    // 索引文件缺失（首次运行或旧版数据）或没有重建完时从 books.dat 重建
+    bool has_index = isbn_index.complete() && name_index.complete() &&
+                     author_index.complete() && keyword_index.complete();
+    if (need_init || legacy || !has_index) rebuild_indexes();
+    // 读多写少的部署可以设置环境变量 BOOKSTORE_RESIDENT_CATALOG=1 开启常驻目录
+    const char *resident_env = std::getenv("BOOKSTORE_RESIDENT_CATALOG");
+    if (resident_env != nullptr && std::strcmp(resident_env, "1") == 0) set_resident_catalog(true);
+}
+
+void BookManager::set_resident_catalog(bool on) {
+    resident = on;
+    catalog.clear();
+    if (!on) return;
+    int n = 0;
+    book_file.get_info(n, 1);
+    Book book;
+    book_file.for_each(0, n, [](const BookRecord &) { return true; },
+                       [&](const BookRecord &record, int) {
+                           load_book(record, book);
+                           catalog.put(catalog.size(), book);
+                       });
+}
+
+int BookManager::row_of(int pos) const {
+    return (pos - book_file.record_pos(0)) / static_cast<int>(sizeof(BookRecord));
+}
+
+// 旧版 books.dat 的文件头为记录数，其后是定长的 Book；
+// 逐本转成紧凑记录，文字追加到 books.str；记录先写入临时文件，落盘后再替换旧文件
+void BookManager::upgrade_legacy_file() {
+    const char *FN = "books.dat";
+    std::ifstream fin(FN, std::ios::binary);
+    int n = 0;
+    fin.read(reinterpret_cast<char *>(&n), sizeof(int));
+    text_file.initialise();
+    std::vector<BookRecord> records;
+    Book old;
+    for (int i = 0; i < n && fin.read(reinterpret_cast<char *>(&old), sizeof(old)); ++i) {
+        BookRecord record;
+        std::memcpy(record.isbn, old.isbn, sizeof(record.isbn));
+        record.quantity = old.quantity;
+        record.price_cents = price_to_cents(old.price);
+        if (old.isbn[0] != '\0') store_text(old, record);
+        records.push_back(record);
     }
     fin.close();
-    if (need_init) book_file.initialise();
+
+    text_file.sync();
+    book_file.initialise(std::string(FN) + ".tmp");
+    book_file.write_info(kBookMagic, 2);
+    book_file.append_range(records.data(), static_cast<int>(records.size()));
+    book_file.write_info(static_cast<int>(records.size()), 1);
+    book_file.replace(FN);
+}
+
+void BookManager::attach_journal(Journal &journal) {
+    book_file.set_journal(&journal);
+    text_file.set_journal(&journal);
+    isbn_index.set_journal(&journal);
+    name_index.set_journal(&journal);
+    author_index.set_journal(&journal);
+    keyword_index.set_journal(&journal);
+}
+
+void BookManager::rebuild_indexes() {
+    isbn_index.initialise();
+    name_index.initialise();
+    author_index.initialise();
+    keyword_index.initialise();
+
+    int n = 0;
+    book_file.get_info(n, 1);
+    const Book blank;
+    Book book;
+    book_file.for_each(0, n, [](const BookRecord &record) { return record.isbn[0] != '\0'; },
+                       [&](const BookRecord &record, int pos) {
+                           isbn_index.insert(IsbnKey(record.isbn), pos);
+                           load_book(record, book);
+                           reindex(blank, book, pos);
+                       });
+    isbn_index.mark_complete();
+    name_index.mark_complete();
+    author_index.mark_complete();
+    keyword_index.mark_complete();
+}
+
+// 把位于 pos 的图书从 old_book 改为 new_book 时同步各二级索引；空字段不进索引
+static void reindex_field(BlockList<FixedString<60>, BookRef> &index,
+                          const char *old_value, const BookRef &old_ref,
+                          const char *new_value, const BookRef &new_ref) {
+    if (std::strcmp(old_value, new_value) == 0 && old_ref == new_ref) return;
+    if (old_value[0] != '\0') index.erase(FixedString<60>(old_value), old_ref);
+    if (new_value[0] != '\0') index.insert(FixedString<60>(new_value), new_ref);
+}
+
+static std::set<std::string> split_keywords(const char *keywords) {
+    std::set<std::string> result;
+    std::istringstream iss(keywords);
+    std::string k;
+    while (std::getline(iss, k, '|')) {
+        if (!k.empty()) result.insert(k);
+    }
+    return result;
+}
+
+void BookManager::reindex(const Book &old_book, const Book &new_book, int pos) {
+    const BookRef old_ref(IsbnKey(old_book.isbn), pos);
+    const BookRef new_ref(IsbnKey(new_book.isbn), pos);
+    reindex_field(name_index, old_book.name, old_ref, new_book.name, new_ref);
+    reindex_field(author_index, old_book.author, old_ref, new_book.author, new_ref);
+
+    // 关键词：ISBN 未变时只改动新旧关键词集合的差集
+    if (std::strcmp(old_book.keywords, new_book.keywords) == 0 && old_ref == new_ref) return;
+    const std::set<std::string> old_keys = split_keywords(old_book.keywords);
+    const std::set<std::string> new_keys = split_keywords(new_book.keywords);
+    const bool moved = !(old_ref == new_ref);
+    for (const auto &k : old_keys) {
+        if (moved || !new_keys.count(k)) keyword_index.erase(TextKey(k), old_ref);
+    }
+    for (const auto &k : new_keys) {
+        if (moved || !old_keys.count(k)) keyword_index.insert(TextKey(k), new_ref);
+    }
 }
 
 bool BookManager::validate_isbn(const std::string &isbn) {
@@ -130,168 +280,190 @@ bool BookManager::validate_keywords(const std::string &keywords_str) {
 }
 
 
-bool BookManager::find_by_isbn(const std::string &isbn_str, Book &book, int &index) {
-    int n = 0;
-    book_file.get_info(n, 1);
-
-    for (int i = 1; i <= n; ++i) {
-        int pos = sizeof(int) + (i - 1) * sizeof(Book);
-        Book tmp;
-        book_file.read(tmp, pos);
-        if (tmp.isbn[0] == '\0') continue;
+bool BookManager::find_by_isbn(const std::string &isbn_str, BookRecord &record, int &index) {
+    if (isbn_str.empty() || isbn_str.size() > 20) return false;
 
-        if (std::strcmp(isbn_str.c_str(), tmp.isbn) == 0) {
-            book = tmp;
-            index = pos;
-            return true;
-        }
+    CachedBook cached;
+    if (book_cache.get(isbn_str, cached)) {
+        record = cached.record;
+        index = cached.pos;
+        return true;
     }
-    return false;
-}
 
-std::vector<Book> BookManager::get_all_books() {
-    std::vector<Book> books;
-    int n = 0;
-    book_file.get_info(n, 1);
+    int pos = 0;
+    if (!isbn_index.find(IsbnKey(isbn_str), pos)) return false;
 
-    for (int i = 1; i <= n; ++i) {
-        int pos = sizeof(int) + (i - 1) * sizeof(Book);
-        Book book;
-        book_file.read(book, pos);
-        if (book.isbn[0] != '\0') {
-            books.push_back(book);
-        }
-    }
+    // 索引按完整的定长 ISBN 匹配，读出的记录无需再比较
+    book_file.read(record, pos);
+    index = pos;
+    cached.record = record;
+    cached.pos = pos;
+    book_cache.put(isbn_str, cached);
+    return true;
+}
 
-    std::sort(books.begin(), books.end(),
-              [](const Book &a, const Book &b) {
-                  return std::strcmp(a.isbn, b.isbn) < 0;
-              });
+// 写回 books.dat 并同步更新缓存
+void BookManager::store_record(const BookRecord &record, int pos) {
+    BookRecord copy = record;
+    book_file.update(copy, pos);
+    CachedBook cached;
+    cached.record = record;
+    cached.pos = pos;
+    book_cache.put(record.isbn, cached);
+}
 
-    return books;
+// 解码出完整的图书，三段文字一次读出
+void BookManager::load_book(const BookRecord &record, Book &book) {
+    char text[3 * 60];
+    int len = record.text_len();
+    if (len > 0) text_file.read_bytes(text, record.text, len);
+    book = Book();
+    std::memcpy(book.isbn, record.isbn, sizeof(book.isbn));
+    const char *p = text;
+    std::memcpy(book.name, p, record.name_len);
+    p += record.name_len;
+    std::memcpy(book.author, p, record.author_len);
+    p += record.author_len;
+    std::memcpy(book.keywords, p, record.keywords_len);
+    book.price = record.price_cents / 100.0;
+    book.quantity = record.quantity;
+}
+
+// 把 book 的三段文字追加到 books.str，并在 record 中记下位置与长度
+void BookManager::store_text(const Book &book, BookRecord &record) {
+    std::string text;
+    text.append(book.name).append(book.author).append(book.keywords);
+    record.name_len = static_cast<unsigned char>(std::strlen(book.name));
+    record.author_len = static_cast<unsigned char>(std::strlen(book.author));
+    record.keywords_len = static_cast<unsigned char>(std::strlen(book.keywords));
+    record.text = text_file.append_range(text.data(), static_cast<int>(text.size()));
 }
 
 void BookManager::print_book(const Book &book) {
-    std::cout << book.isbn << '\t'
-              << book.name << '\t'
-              << book.author << '\t'
-              << book.keywords << '\t';
-    std::cout << std::fixed << std::setprecision(2)
-              << book.price << '\t'
-              << book.quantity << '\n';
+    output() << book.isbn << '\t'
+             << book.name << '\t'
+             << book.author << '\t'
+             << book.keywords << '\t'
+             << Fixed2(book.price) << '\t'
+             << book.quantity << '\n';
 }
 
+// 沿 ISBN 索引的叶子链表逐本读取并输出，结果按 ISBN 升序排列
 void BookManager::show_all() {
-    auto books = get_all_books();
-    for (const auto &book : books) {
-        print_book(book);
+    if (resident) {
+        if (catalog.show(BookFilter()) == 0) output() << '\n';
+        return;
     }
-    if (books.empty()) {
-        std::cout << '\n';
+    int shown = 0;
+    BookRecord record;
+    Book book;
+    isbn_index.for_each([&](const IsbnKey &, int pos) {
+        book_file.read(record, pos);
+        load_book(record, book);
+        print_book(book);
+        ++shown;
+    });
+    if (shown == 0) {
+        output() << '\n';
     }
 }
 
-void BookManager::show_by_isbn(const std::string &isbn) {
-    auto books = get_all_books();
-    bool found = false;
-    for (const auto &book : books) {
-        if (std::strcmp(book.isbn, isbn.c_str()) == 0) {
-            print_book(book);
-            found = true;
-        }
-    }
-    if (!found) {
-        std::cout << '\n';
-    }
+// 只用定长部分排除：ISBN 不同或文字长度对不上的记录不必读出文字
+bool BookManager::may_match(const BookRecord &record, const BookFilter &filter) {
+    if (!filter.isbn.empty() && filter.isbn != record.isbn) return false;
+    if (!filter.name.empty() && filter.name.size() != record.name_len) return false;
+    if (!filter.author.empty() && filter.author.size() != record.author_len) return false;
+    return filter.keyword.size() <= record.keywords_len;
 }
 
-void BookManager::show_by_name(const std::string &name) {
-    auto books = get_all_books();
-    bool found = false;
-    for (const auto &book : books) {
-        if (std::strcmp(book.name, name.c_str()) == 0) {
-            print_book(book);
-            found = true;
-        }
-    }
-    if (!found) {
-        std::cout << '\n';
+bool BookManager::matches(const Book &book, const BookFilter &filter) {
+    if (!filter.isbn.empty() && filter.isbn != book.isbn) return false;
+    if (!filter.name.empty() && filter.name != book.name) return false;
+    if (!filter.author.empty() && filter.author != book.author) return false;
+    if (filter.keyword.empty()) return true;
+    // 在以 '|' 分隔的关键词中逐段比较
+    const char *p = book.keywords;
+    const size_t n = filter.keyword.size();
+    while (true) {
+        const char *bar = std::strchr(p, '|');
+        size_t len = bar == nullptr ? std::strlen(p) : static_cast<size_t>(bar - p);
+        if (len == n && std::memcmp(p, filter.keyword.data(), n) == 0) return true;
+        if (bar == nullptr) return false;
+        p = bar + 1;
     }
 }
 
-void BookManager::show_by_author(const std::string &author) {
-    auto books = get_all_books();
-    bool found = false;
-    for (const auto &book : books) {
-        if (std::strcmp(book.author, author.c_str()) == 0) {
-            print_book(book);
-            found = true;
-        }
-    }
-    if (!found) {
-        std::cout << '\n';
+// 从最有选择性的条件取候选集（ISBN > 书名 > 作者 > 关键词），一遍检查其余条件，
+// 按 ISBN 升序输出
+void BookManager::show_matching(const BookFilter &filter) {
+    if (resident) {
+        if (catalog.show(filter) == 0) output() << '\n';
+        return;
     }
-}
-
-void BookManager::show_by_keyword(const std::string &keyword) {
-    auto books = get_all_books();
-    bool found = false;
-
-    for (const auto &book : books) {
-        std::string keywords_str(book.keywords);
-        std::istringstream iss(keywords_str);
-        std::string k;
-        bool has_keyword = false;
-
-        while (std::getline(iss, k, '|')) {
-            if (k == keyword) {
-                has_keyword = true;
-                break;
+    int shown = 0;
+    BookRecord record;
+    Book book;
+    if (!filter.isbn.empty()) {
+        int idx = 0;
+        if (find_by_isbn(filter.isbn, record, idx) && may_match(record, filter)) {
+            load_book(record, book);
+            if (matches(book, filter)) {
+                print_book(book);
+                ++shown;
             }
         }
-
-        if (has_keyword) {
+    } else {
+        std::vector<BookRef> refs;
+        if (!filter.name.empty()) refs = name_index.find(TextKey(filter.name));
+        else if (!filter.author.empty()) refs = author_index.find(TextKey(filter.author));
+        else if (!filter.keyword.empty()) refs = keyword_index.find(TextKey(filter.keyword));
+        for (const auto &ref : refs) {
+            book_file.read(record, ref.pos);
+            if (!may_match(record, filter)) continue;
+            load_book(record, book);
+            if (!matches(book, filter)) continue;
             print_book(book);
-            found = true;
+            ++shown;
         }
     }
-
-    if (!found) {
-        std::cout << '\n';
+    if (shown == 0) {
+        output() << '\n';
     }
 }
 
 bool BookManager::buy(const std::string &isbn_str, int q, double &total_cost) {
     if (q <= 0) return false;
 
-    Book book;
+    BookRecord record;
     int idx = 0;
-    if (!find_by_isbn(isbn_str, book, idx)) return false;
-    if (book.quantity < q) return false;
+    if (!find_by_isbn(isbn_str, record, idx)) return false;
+    if (record.quantity < q) return false;
 
-    book.quantity -= q;
-    book_file.update(book, idx);
+    record.quantity -= q;
+    store_record(record, idx);
+    if (resident) catalog.set_quantity(row_of(idx), record.quantity);
 
-    total_cost = book.price * q;
+    total_cost = record.price_cents / 100.0 * q;
     return true;
 }
 
 bool BookManager::select(const std::string &isbn_str, Session &session) {
     if (!validate_isbn(isbn_str)) return false;
 
-    Book book;
+    BookRecord record;
     int idx = 0;
-    if (!find_by_isbn(isbn_str, book, idx)) {
-        // 创建新图书
-        Book new_book(isbn_str);
+    if (!find_by_isbn(isbn_str, record, idx)) {
+        // 创建新图书，文字均为空
+        BookRecord new_record;
+        std::strncpy(new_record.isbn, isbn_str.c_str(), 20);
         int n = 0;
         book_file.get_info(n, 1);
 
-        const int HEADER = sizeof(int);
-        idx = HEADER + n * static_cast<int>(sizeof(Book));
-
-        book_file.write(new_book);
+        idx = book_file.record_pos(n);
+        book_file.write(new_record);
         book_file.write_info(n + 1, 1);
+        isbn_index.insert(IsbnKey(new_record.isbn), idx);
+        if (resident) catalog.put(row_of(idx), Book(isbn_str));
     }
 
     session.selected_pos = idx;
@@ -302,12 +474,12 @@ bool BookManager::modify(const int &selected_pos,
                          const std::vector<std::pair<std::string, std::string>> &modifications) {
     if (modifications.empty()) return false;
 
-    if (selected_pos < static_cast<int>(sizeof(int))) return false;
+    if (selected_pos < book_file.record_pos(0)) return false;
 
-    Book book;
-    book_file.read(book, selected_pos);
+    BookRecord record;
+    book_file.read(record, selected_pos);
 
-    if (book.isbn[0] == '\0') return false;
+    if (record.isbn[0] == '\0') return false;
 
     // 检查是否有重复参数
     std::set<std::string> seen_keys;
@@ -322,16 +494,20 @@ bool BookManager::modify(const int &selected_pos,
         if (mod.first == "ISBN") {
             if (!validate_isbn(mod.second)) return false;
 
-            if (std::strcmp(book.isbn, mod.second.c_str()) == 0) return false;
+            if (std::strcmp(record.isbn, mod.second.c_str()) == 0) return false;
 
-            Book existing_book;
+            BookRecord existing;
             int existing_idx = 0;
-            if (find_by_isbn(mod.second, existing_book, existing_idx)) {
+            if (find_by_isbn(mod.second, existing, existing_idx)) {
                 if (existing_idx != selected_pos) return false;
             }
         }
     }
 
+    Book book;
+    load_book(record, book);
+    const Book old_book = book;
+
     // 应用修改
     for (const auto& mod : modifications) {
         const std::string& key = mod.first;
@@ -372,20 +548,38 @@ bool BookManager::modify(const int &selected_pos,
         }
     }
     
-    book_file.update(book, selected_pos);
+    // 文字有变化时整段追加到文字堆
+    std::memcpy(record.isbn, book.isbn, sizeof(record.isbn));
+    record.price_cents = price_to_cents(book.price);
+    if (std::strcmp(book.name, old_book.name) != 0 || std::strcmp(book.author, old_book.author) != 0 ||
+        std::strcmp(book.keywords, old_book.keywords) != 0) {
+        store_text(book, record);
+    }
+
+    const IsbnKey old_isbn(old_book.isbn), new_isbn(book.isbn);
+    if (new_isbn != old_isbn) book_cache.erase(old_book.isbn);
+    store_record(record, selected_pos);
+
+    if (new_isbn != old_isbn) {
+        isbn_index.erase(old_isbn);
+        isbn_index.insert(new_isbn, selected_pos);
+    }
+    reindex(old_book, book, selected_pos);
+    if (resident) catalog.put(row_of(selected_pos), book);
     return true;
 }
 
 bool BookManager::import(const int &selected_pos,
                          int quantity, double total_cost) {
     if (quantity <= 0 || total_cost <= 0) return false;
-    if (selected_pos < static_cast<int>(sizeof(int))) return false;
+    if (selected_pos < book_file.record_pos(0)) return false;
 
-    Book book;
-    book_file.read(book, selected_pos);
-    if (book.isbn[0] == '\0') return false;
+    BookRecord record;
+    book_file.read(record, selected_pos);
+    if (record.isbn[0] == '\0') return false;
 
-    book.quantity += quantity;
-    book_file.update(book, selected_pos);
+    record.quantity += quantity;
+    store_record(record, selected_pos);
+    if (resident) catalog.set_quantity(row_of(selected_pos), record.quantity);
     return true;
 }
\ No newline at end of file
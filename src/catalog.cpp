@@ -0,0 +1,133 @@
+#include "include/catalog.h"
+#include "include/book.h"
+#include "include/output.h"
+
+#include <sstream>
+
+int BookCatalog::Dictionary::intern(const std::string &word) {
+    auto it = ids.find(word);
+    if (it != ids.end()) return it->second;
+    int id = static_cast<int>(words.size());
+    words.push_back(word);
+    ids.emplace(word, id);
+    return id;
+}
+
+int BookCatalog::Dictionary::find(const std::string &word) const {
+    auto it = ids.find(word);
+    return it == ids.end() ? -1 : it->second;
+}
+
+void BookCatalog::clear() {
+    texts = Dictionary();
+    keywords = Dictionary();
+    isbn.clear();
+    name_id.clear();
+    author_id.clear();
+    keywords_id.clear();
+    keyword_bits.clear();
+    keyword_first.clear();
+    keyword_count.clear();
+    keyword_pool.clear();
+    price_cents.clear();
+    quantity.clear();
+    order.clear();
+}
+
+// order 中第一个 ISBN 不小于 key 的位置
+int BookCatalog::order_position(const FixedString<20> &key) const {
+    int lo = 0, hi = static_cast<int>(order.size());
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (isbn[order[mid]] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void BookCatalog::put(int row, const Book &book) {
+    const FixedString<20> key(book.isbn);
+    if (row == size()) {
+        isbn.push_back(key);
+        name_id.push_back(0);
+        author_id.push_back(0);
+        keywords_id.push_back(0);
+        keyword_bits.push_back(0);
+        keyword_first.push_back(0);
+        keyword_count.push_back(0);
+        price_cents.push_back(0);
+        quantity.push_back(0);
+        order.insert(order.begin() + order_position(key), row);
+    } else if (isbn[row] != key) {
+        order.erase(order.begin() + order_position(isbn[row]));
+        isbn[row] = key;
+        order.insert(order.begin() + order_position(key), row);
+    }
+
+    name_id[row] = texts.intern(book.name);
+    author_id[row] = texts.intern(book.author);
+    int whole = texts.intern(book.keywords);
+    if (whole != keywords_id[row] || keyword_count[row] == 0) {
+        keywords_id[row] = whole;
+        keyword_bits[row] = 0;
+        keyword_first[row] = static_cast<int>(keyword_pool.size());
+        std::istringstream iss(book.keywords);
+        std::string word;
+        while (std::getline(iss, word, '|')) {
+            if (word.empty()) continue;
+            int id = keywords.intern(word);
+            keyword_pool.push_back(id);
+            keyword_bits[row] |= uint64_t(1) << (id % 64);
+        }
+        keyword_count[row] = static_cast<int>(keyword_pool.size()) - keyword_first[row];
+    }
+    price_cents[row] = static_cast<long long>(book.price * 100 + 0.5);
+    quantity[row] = book.quantity;
+}
+
+bool BookCatalog::has_keyword(int row, int id) const {
+    if (!(keyword_bits[row] >> (id % 64) & 1u)) return false;
+    const int *p = keyword_pool.data() + keyword_first[row];
+    for (int i = 0; i < keyword_count[row]; ++i) {
+        if (p[i] == id) return true;
+    }
+    return false;
+}
+
+void BookCatalog::print_row(int row) const {
+    output() << isbn[row].str << '\t'
+             << texts.words[name_id[row]] << '\t'
+             << texts.words[author_id[row]] << '\t'
+             << texts.words[keywords_id[row]] << '\t'
+             << Fixed2(price_cents[row] / 100.0) << '\t'
+             << quantity[row] << '\n';
+}
+
+// 条件中的字符串先换成编号，不在字典中的直接判为无结果；
+// 之后按 ISBN 顺序逐行比较编号
+int BookCatalog::show(const BookFilter &filter) {
+    int name = -1, author = -1, keyword = -1;
+    if (!filter.name.empty() && (name = texts.find(filter.name)) < 0) return 0;
+    if (!filter.author.empty() && (author = texts.find(filter.author)) < 0) return 0;
+    if (!filter.keyword.empty() && (keyword = keywords.find(filter.keyword)) < 0) return 0;
+
+    int first = 0, last = static_cast<int>(order.size());
+    if (!filter.isbn.empty()) {
+        if (filter.isbn.size() > 20) return 0;
+        const FixedString<20> key(filter.isbn);
+        first = order_position(key);
+        if (first == last || isbn[order[first]] != key) return 0;
+        last = first + 1;
+    }
+
+    int shown = 0;
+    for (int i = first; i < last; ++i) {
+        int row = order[i];
+        if (name >= 0 && name_id[row] != name) continue;
+        if (author >= 0 && author_id[row] != author) continue;
+        if (keyword >= 0 && !has_keyword(row, keyword)) continue;
+        print_row(row);
+        ++shown;
+    }
+    return shown;
+}
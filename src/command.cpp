@@ -1,110 +1,124 @@
 #include "include/command.h"
-#include <sstream>
 #include <algorithm>
-#include <cctype>
 
-std::string CommandParser::trim(const std::string &str) {
-    size_t l = 0;
-    while (l < str.size() && std::isspace(static_cast<unsigned char>(str[l]))) ++l;
-
-    if (l == str.size()) return "";
-
-    size_t r = str.size() - 1;
-    while (r > l && std::isspace(static_cast<unsigned char>(str[r]))) --r;
+namespace {
+
+struct Opcode {
+    const char *name;
+    CommandType type;
+};
+
+// 按名称升序排列，二分查找
+const Opcode kOpcodes[] = {
+    {"buy", CommandType::Buy},
+    {"delete", CommandType::DeleteUser},
+    {"exit", CommandType::Exit},
+    {"import", CommandType::Import},
+    {"log", CommandType::Log},
+    {"logout", CommandType::Logout},
+    {"modify", CommandType::Modify},
+    {"passwd", CommandType::Passwd},
+    {"quit", CommandType::Quit},
+    {"register", CommandType::Register},
+    {"select", CommandType::Select},
+    {"show", CommandType::Show},
+    {"su", CommandType::Su},
+    {"useradd", CommandType::UserAdd},
+};
+
+// 由两个词组成的指令，先于单词指令匹配
+struct SubOpcode {
+    const char *name;
+    const char *sub;
+    CommandType type;
+};
+
+const SubOpcode kSubOpcodes[] = {
+    {"show", "finance", CommandType::ShowFinance},
+    {"report", "finance", CommandType::ReportFinance},
+    {"report", "employee", CommandType::ReportEmployee},
+};
+
+int compare(const StrView &a, const char *b) {
+    size_t n = std::strlen(b);
+    int c = std::memcmp(a.data, b, std::min(a.size, n));
+    if (c != 0) return c;
+    return a.size < n ? -1 : (a.size > n ? 1 : 0);
+}
 
-    return str.substr(l, r - l + 1);
+CommandType lookup(const StrView &op) {
+    const Opcode *first = kOpcodes;
+    const Opcode *last = kOpcodes + sizeof(kOpcodes) / sizeof(kOpcodes[0]);
+    const Opcode *it = std::lower_bound(first, last, op, [](const Opcode &entry, const StrView &key) {
+        return compare(key, entry.name) > 0;
+    });
+    if (it != last && compare(op, it->name) == 0) return it->type;
+    return CommandType::Unknown;
 }
 
-std::vector<std::string> CommandParser::split(const std::string &line) {
-    std::vector<std::string> result;
+}  // namespace
 
+// 空格是唯一的分隔符，引号内的空格不分隔；未闭合引号一直延续到行尾（去掉末尾空格）
+LineStatus CommandParser::split(const std::string &line) {
+    tokens.clear();
+    const char *p = line.data();
+    const size_t n = line.size();
     bool in_quotes = false;
-    std::string current_token;
-
-    for (size_t i = 0; i < line.size(); ++i) {
-        char c = line[i];
-
-        if (c == '"') {
-            in_quotes = !in_quotes;
-            current_token += c;
+    size_t start = 0;
+    bool in_token = false;
+
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = static_cast<unsigned char>(p[i]);
+        if (c < 32 || c > 126) return LineStatus::Bad;
+        if (c == ' ' && !in_quotes) {
+            if (in_token) tokens.push_back(StrView{p + start, i - start});
+            in_token = false;
             continue;
         }
-
-        // 空格/tab 等在非引号内都作为分隔符
-        if (!in_quotes && std::isspace(static_cast<unsigned char>(c))) {
-            std::string t = trim(current_token);
-            if (!t.empty()) result.push_back(t);
-            current_token.clear();
-        } else {
-            current_token += c;
+        if (!in_token) {
+            start = i;
+            in_token = true;
         }
+        if (c == '"') in_quotes = !in_quotes;
     }
-
-    std::string t = trim(current_token);
-    if (!t.empty()) result.push_back(t);
-
-    return result;
+    if (in_token) {
+        size_t end = n;
+        while (end > start && p[end - 1] == ' ') --end;
+        tokens.push_back(StrView{p + start, end - start});
+    }
+    return tokens.empty() ? LineStatus::Blank : LineStatus::Ok;
 }
 
-
-Command CommandParser::parse(const std::string &line) {
-    Command cmd;
+LineStatus CommandParser::parse(const std::string &line, Command &cmd) {
     cmd.type = CommandType::Unknown;
-    
-    std::vector<std::string> tokens = split(line);
-    if (tokens.empty()) {
+    LineStatus status = split(line);
+    if (status != LineStatus::Ok) {
         cmd.type = CommandType::Empty;
-        return cmd;
+        cmd.args.clear();
+        return status;
     }
-    
-    std::string op = tokens[0];
-    
-    if (op == "quit") cmd.type = CommandType::Quit;
-    else if (op == "exit") cmd.type = CommandType::Exit;
-    else if (op == "register") cmd.type = CommandType::Register;
-    else if (op == "su") cmd.type = CommandType::Su;
-    else if (op == "logout") cmd.type = CommandType::Logout;
-    else if (op == "passwd") cmd.type = CommandType::Passwd;
-    else if (op == "useradd") cmd.type = CommandType::UserAdd;
-    else if (op == "delete") cmd.type = CommandType::DeleteUser;
-    else if (op == "show") {
-        if (tokens.size() > 1 && tokens[1] == "finance") {
-            cmd.type = CommandType::ShowFinance;
-            for (size_t i = 2; i < tokens.size(); ++i) {
-                cmd.args.push_back(tokens[i]);
-            }
-        } else {
-            cmd.type = CommandType::Show;
-            for (size_t i = 1; i < tokens.size(); ++i) {
-                cmd.args.push_back(tokens[i]);
+
+    size_t first_arg = 1;
+    if (tokens.size() > 1) {
+        for (const SubOpcode &entry : kSubOpcodes) {
+            if (tokens[0] == entry.name && tokens[1] == entry.sub) {
+                cmd.type = entry.type;
+                first_arg = 2;
+                break;
             }
         }
     }
-    else if (op == "buy") cmd.type = CommandType::Buy;
-    else if (op == "select") cmd.type = CommandType::Select;
-    else if (op == "modify") cmd.type = CommandType::Modify;
-    else if (op == "import") cmd.type = CommandType::Import;
-    else if (op == "log") cmd.type = CommandType::Log;
-    else if (op == "report") {
-        if (tokens.size() > 1) {
-            if (tokens[1] == "finance") cmd.type = CommandType::ReportFinance;
-            else if (tokens[1] == "employee") cmd.type = CommandType::ReportEmployee;
-        }
-    }
-    
-    // 统一填充参数
-    if (cmd.type == CommandType::ShowFinance) {
-
-    } else if (cmd.type == CommandType::Show) {
+    if (first_arg == 1) cmd.type = lookup(tokens[0]);
 
-    } else if (cmd.type == CommandType::ReportFinance || cmd.type == CommandType::ReportEmployee) {
-        // report finance / report employee：无额外参数
-    } else if (cmd.type != CommandType::Quit && cmd.type != CommandType::Exit
-               && cmd.type != CommandType::Empty && cmd.type != CommandType::Unknown) {
-        for (size_t i = 1; i < tokens.size(); ++i) {
-            cmd.args.push_back(tokens[i]);
-        }
-               }
-
-    return cmd;
-}
\ No newline at end of file
+    // report finance / report employee、quit / exit 和未知指令不带参数
+    size_t count = 0;
+    if (cmd.type != CommandType::Unknown && cmd.type != CommandType::Quit && cmd.type != CommandType::Exit &&
+        cmd.type != CommandType::ReportFinance && cmd.type != CommandType::ReportEmployee) {
+        count = tokens.size() - first_arg;
+    }
+    cmd.args.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        cmd.args[i].assign(tokens[first_arg + i].data, tokens[first_arg + i].size);
+    }
+    return status;
+}
@@ -1,123 +1,163 @@
 #include "include/finance.h"
+#include "include/output.h"
 
-#include <iostream>
-#include <iomanip>
 #include <fstream>
+#include <vector>
+
+namespace {
+
+// 区分新旧格式的文件头：旧版 info1 为总收入（分），不会是负数
+const int kLedgerMagic = -0x4C444752;
+const int kHeader = 2 * sizeof(int);
+
+// 旧版记录：单笔交易的方向与金额
+struct LegacyFinanceRecord {
+    bool is_income;
+    double amount;
+};
+
+long long to_cents(double amount) {
+    return static_cast<long long>(amount * 100 + 0.5);  // 四舍五入
+}
+
+void print_cents(long long cents) {
+    if (cents < 0) {
+        output() << '-';
+        cents = -cents;
+    }
+    output() << cents / 100 << '.' << static_cast<char>('0' + cents % 100 / 10)
+             << static_cast<char>('0' + cents % 10);
+}
+
+}  // namespace
 
 FinanceManager::FinanceManager()
-    : finance_file("finance.dat") {
+    : finance_file("finance.dat", RiverMode::Mapped) {
     std::ifstream fin("finance.dat", std::ios::binary);
     bool need_init = false;
+    int magic = 0;
     if (!fin.good()) {
         need_init = true;
     } else {
         fin.seekg(0, std::ios::end);
-        if (fin.tellg() < static_cast<std::streamoff>(3 * sizeof(int))) need_init = true;
+        if (fin.tellg() < static_cast<std::streamoff>(kHeader)) need_init = true;
+        fin.seekg(0, std::ios::beg);
+        fin.read(reinterpret_cast<char *>(&magic), sizeof(int));
     }
     fin.close();
-    if (need_init) finance_file.initialise();
+    if (need_init) {
+        finance_file.initialise();
+        finance_file.write_info(kLedgerMagic, 1);
+        finance_file.write_info(0, 2);
+    } else if (magic != kLedgerMagic) {
+        upgrade_legacy_file();
+    }
 }
 
-void FinanceManager::add_income(double amount) {
-    FinanceRecord record(true, amount);
-    finance_file.write(record);
+void FinanceManager::attach_journal(Journal &journal) {
+    finance_file.set_journal(&journal);
+}
 
-    // 读取当前总收入（以分为单位，避免浮点误差）
-    int total_income_cents = 0;
-    finance_file.get_info(total_income_cents, 1);
-    // 增加收入（转换为分）
-    total_income_cents += static_cast<int>(amount * 100 + 0.5); // 四舍五入
-    finance_file.write_info(total_income_cents, 1);
+// 旧版 finance.dat 的文件头为 总收入(分), 总支出(分), 记录数，记录为单笔金额；
+// 逐笔累加后按新格式写入临时文件，落盘后再替换旧文件
+void FinanceManager::upgrade_legacy_file() {
+    const char *FN = "finance.dat";
+    std::ifstream fin(FN, std::ios::binary);
+    int header[3] = {0, 0, 0};
+    fin.read(reinterpret_cast<char *>(header), sizeof(header));
+    std::vector<FinanceRecord> totals;
+    FinanceRecord total;
+    LegacyFinanceRecord old;
+    for (int i = 0; i < header[2] && fin.read(reinterpret_cast<char *>(&old), sizeof(old)); ++i) {
+        if (old.is_income) total.income_cents += to_cents(old.amount);
+        else total.expense_cents += to_cents(old.amount);
+        totals.push_back(total);
+    }
+    fin.close();
 
-    // 更新记录数
-    int count = 0;
-    finance_file.get_info(count, 3);
-    finance_file.write_info(count + 1, 3);
+    finance_file.initialise(std::string(FN) + ".tmp");
+    finance_file.write_info(kLedgerMagic, 1);
+    finance_file.append_range(totals.data(), static_cast<int>(totals.size()));
+    finance_file.write_info(static_cast<int>(totals.size()), 2);
+    finance_file.replace(FN);
 }
 
-void FinanceManager::add_expense(double amount) {
-    FinanceRecord record(false, amount);
+FinanceRecord FinanceManager::total_after(int i) {
+    FinanceRecord record;
+    if (i > 0) finance_file.read_range(i - 1, 1, &record);
+    return record;
+}
+
+void FinanceManager::append(long long income_cents, long long expense_cents) {
+    int count = 0;
+    finance_file.get_info(count, 2);
+    FinanceRecord record = total_after(count);
+    record.income_cents += income_cents;
+    record.expense_cents += expense_cents;
     finance_file.write(record);
+    finance_file.write_info(count + 1, 2);
+}
 
-    // 读取当前总支出（以分为单位）
-    int total_expense_cents = 0;
-    finance_file.get_info(total_expense_cents, 2);
-    total_expense_cents += static_cast<int>(amount * 100 + 0.5);
-    finance_file.write_info(total_expense_cents, 2);
+void FinanceManager::add_income(double amount) {
+    append(to_cents(amount), 0);
+}
 
-    // 更新记录数
-    int count = 0;
-    finance_file.get_info(count, 3);
-    finance_file.write_info(count + 1, 3);
+void FinanceManager::add_expense(double amount) {
+    append(0, to_cents(amount));
 }
 
 void FinanceManager::show_last_n(int n) {
     int total_count = 0;
-    finance_file.get_info(total_count, 3);
+    finance_file.get_info(total_count, 2);
 
     if (n > total_count) {
-        std::cout << "Invalid\n";
+        output() << "Invalid\n";
         return;
     }
 
     if (n == 0) {
-        std::cout << "\n";
+        output() << "\n";
         return;
     }
 
-    double income = 0, expense = 0;
-    int start = total_count - n + 1;
+    FinanceRecord last = total_after(total_count);
+    FinanceRecord before = total_after(total_count - n);
 
-    for (int i = start; i <= total_count; ++i) {
-        int pos = sizeof(int) * 3 + (i - 1) * sizeof(FinanceRecord);
-        FinanceRecord record;
-        finance_file.read(record, pos);
-
-        if (record.is_income) {
-            income += record.amount;
-        } else {
-            expense += record.amount;
-        }
-    }
-
-    std::cout << std::fixed << std::setprecision(2)
-              << "+ " << income << " - " << expense << '\n';
+    output() << "+ ";
+    print_cents(last.income_cents - before.income_cents);
+    output() << " - ";
+    print_cents(last.expense_cents - before.expense_cents);
+    output() << '\n';
 }
 
 void FinanceManager::show_all() {
-    // 读取总收入和总支出（以分为单位）
-    int total_income_cents = 0, total_expense_cents = 0;
-    finance_file.get_info(total_income_cents, 1);
-    finance_file.get_info(total_expense_cents, 2);
-
-    // 转换为元
-    double income = total_income_cents / 100.0;
-    double expense = total_expense_cents / 100.0;
-
-    std::cout << std::fixed << std::setprecision(2)
-              << "+ " << income << " - " << expense << '\n';
+    int total_count = 0;
+    finance_file.get_info(total_count, 2);
+    FinanceRecord last = total_after(total_count);
+
+    output() << "+ ";
+    print_cents(last.income_cents);
+    output() << " - ";
+    print_cents(last.expense_cents);
+    output() << '\n';
 }
 
 void FinanceManager::generate_report() {
-    // 读取总收入和总支出（以分为单位）
-    int total_income_cents = 0, total_expense_cents = 0;
-    finance_file.get_info(total_income_cents, 1);
-    finance_file.get_info(total_expense_cents, 2);
-
-    // 转换为元
-    double total_income = total_income_cents / 100.0;
-    double total_expense = total_expense_cents / 100.0;
-
     int total_count = 0;
-    finance_file.get_info(total_count, 3);
-
-    std::cout << "========================================\n";
-    std::cout << "          财务报表报告\n";
-    std::cout << "========================================\n";
-    std::cout << "总交易笔数: " << total_count << "\n";
-    std::cout << "总收入: " << std::fixed << std::setprecision(2) 
-              << total_income << "\n";
-    std::cout << "总支出: " << total_expense << "\n";
-    std::cout << "净利润: " << (total_income - total_expense) << "\n";
-    std::cout << "========================================\n";
+    finance_file.get_info(total_count, 2);
+    FinanceRecord last = total_after(total_count);
+
+    // 全程以分计算，净利润不经过浮点数
+    output() << "========================================\n";
+    output() << "          财务报表报告\n";
+    output() << "========================================\n";
+    output() << "总交易笔数: " << total_count << "\n";
+    output() << "总收入: ";
+    print_cents(last.income_cents);
+    output() << "\n总支出: ";
+    print_cents(last.expense_cents);
+    output() << "\n净利润: ";
+    print_cents(last.income_cents - last.expense_cents);
+    output() << "\n";
+    output() << "========================================\n";
 }
\ No newline at end of file
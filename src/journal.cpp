@@ -0,0 +1,245 @@
+#include "include/journal.h"
+#include <cstring>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 一个事务的记录格式：
+//   "BTXN" | u32 载荷长度 | 载荷 | u32 载荷校验和 | "ETXN"
+// 载荷由若干操作组成：
+//   u8 类型 | u16 文件名长度 | 文件名 | i64 位置（截短时为新长度） | u32 数据长度 | 数据
+// 校验和或结尾标记不完整的记录视为未提交。
+
+namespace {
+
+const char kBeginMagic[4] = {'B', 'T', 'X', 'N'};
+const char kEndMagic[4] = {'E', 'T', 'X', 'N'};
+const unsigned char kOpWrite = 1;
+const unsigned char kOpTruncate = 2;
+const long kCheckpointBytes = 4L << 20;
+
+uint32_t checksum(const char *data, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+template<class T>
+void put(std::string &out, T value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<class T>
+bool take(const char *&p, const char *end, T &value) {
+    if (end - p < static_cast<long>(sizeof(T))) return false;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+bool write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool pwrite_all(int fd, const char *data, size_t len, off_t pos) {
+    while (len > 0) {
+        ssize_t n = ::pwrite(fd, data, len, pos);
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+        pos += n;
+    }
+    return true;
+}
+
+// 校验一条完整的事务记录，成功时 payload 指向载荷
+bool parse_record(const char *p, const char *end, const char *&payload, uint32_t &len, const char *&next) {
+    if (end - p < 8 || std::memcmp(p, kBeginMagic, 4) != 0) return false;
+    std::memcpy(&len, p + 4, 4);
+    if (static_cast<unsigned long>(end - p - 8) < static_cast<unsigned long>(len) + 8) return false;
+    payload = p + 8;
+    uint32_t sum = 0;
+    std::memcpy(&sum, payload + len, 4);
+    if (sum != checksum(payload, len)) return false;
+    if (std::memcmp(payload + len + 4, kEndMagic, 4) != 0) return false;
+    next = payload + len + 8;
+    return true;
+}
+
+// 把一条事务的载荷重放到各数据文件上
+void replay(const char *p, const char *end, std::vector<std::string> &touched) {
+    while (p < end) {
+        unsigned char type = 0;
+        uint16_t name_len = 0;
+        int64_t pos = 0;
+        uint32_t len = 0;
+        if (!take(p, end, type) || !take(p, end, name_len) || end - p < name_len) return;
+        std::string name(p, name_len);
+        p += name_len;
+        if (!take(p, end, pos) || !take(p, end, len) || static_cast<uint32_t>(end - p) < len) return;
+
+        int fd = ::open(name.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd >= 0) {
+            if (type == kOpTruncate) {
+                if (::ftruncate(fd, pos) != 0) {}
+            } else if (type == kOpWrite) {
+                pwrite_all(fd, p, len, pos);
+            }
+            ::close(fd);
+        }
+        p += len;
+        touched.push_back(name);
+    }
+}
+
+void sync_path(const std::string &name) {
+    int fd = ::open(name.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+}
+
+}  // namespace
+
+Journal::Journal(const std::string &file_name)
+    : file_name(file_name), fd(-1), in_txn(false), sync_on_commit(true), written(0) {
+#ifdef BOOKSTORE_JOURNAL_NOSYNC
+    sync_on_commit = false;
+#endif
+    recover();
+    fd = ::open(file_name.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+}
+
+Journal::~Journal() {
+    if (fd >= 0) ::close(fd);
+}
+
+void Journal::attach(JournalFile *file) {
+    for (JournalFile *f : files) {
+        if (f == file) return;
+    }
+    files.push_back(file);
+}
+
+void Journal::enlist(JournalFile *file) {
+    for (JournalFile *f : enlisted) {
+        if (f == file) return;
+    }
+    enlisted.push_back(file);
+}
+
+void Journal::begin() {
+    in_txn = true;
+}
+
+void Journal::commit() {
+    in_txn = false;
+    if (enlisted.empty()) return;
+
+    std::string payload;
+    for (JournalFile *f : enlisted) f->serialize_pending(payload);
+
+    std::string record;
+    record.reserve(payload.size() + 16);
+    record.append(kBeginMagic, 4);
+    put(record, static_cast<uint32_t>(payload.size()));
+    record += payload;
+    put(record, checksum(payload.data(), payload.size()));
+    record.append(kEndMagic, 4);
+
+    // 日志写入失败时仍然写数据文件，只是失去崩溃保护
+    if (fd >= 0 && write_all(fd, record.data(), record.size())) {
+        if (sync_on_commit) ::fdatasync(fd);
+        written += static_cast<long>(record.size());
+    }
+
+    for (JournalFile *f : enlisted) {
+        f->apply_pending();
+        bool seen = false;
+        for (JournalFile *d : dirty) seen = seen || d == f;
+        if (!seen) dirty.push_back(f);
+    }
+    enlisted.clear();
+
+    // 日志中只有 dirty 中文件的修改，自动检查点只需同步这些文件
+    if (written >= kCheckpointBytes) truncate_log(dirty);
+}
+
+void Journal::checkpoint() {
+    truncate_log(files);
+}
+
+void Journal::truncate_log(const std::vector<JournalFile *> &to_sync) {
+    if (in_txn || fd < 0) return;
+    for (JournalFile *f : to_sync) f->sync();
+    if (::ftruncate(fd, 0) != 0) return;
+    ::fsync(fd);
+    written = 0;
+    dirty.clear();
+}
+
+void Journal::encode_write(std::string &out, const std::string &name,
+                           long pos, const char *data, int len) {
+    put(out, kOpWrite);
+    put(out, static_cast<uint16_t>(name.size()));
+    out += name;
+    put(out, static_cast<int64_t>(pos));
+    put(out, static_cast<uint32_t>(len));
+    out.append(data, len);
+}
+
+void Journal::encode_truncate(std::string &out, const std::string &name, long size) {
+    put(out, kOpTruncate);
+    put(out, static_cast<uint16_t>(name.size()));
+    out += name;
+    put(out, static_cast<int64_t>(size));
+    put(out, static_cast<uint32_t>(0));
+}
+
+// 重放日志中所有完整的事务；遇到第一条不完整的记录即停止，之后的内容都是未提交的
+void Journal::recover() {
+    int in = ::open(file_name.c_str(), O_RDONLY);
+    if (in < 0) return;
+    struct stat st;
+    std::string data;
+    if (::fstat(in, &st) == 0 && st.st_size > 0) {
+        data.resize(st.st_size);
+        long got = 0;
+        while (got < st.st_size) {
+            ssize_t n = ::read(in, &data[got], st.st_size - got);
+            if (n <= 0) break;
+            got += n;
+        }
+        data.resize(got);
+    }
+    ::close(in);
+    if (data.empty()) return;
+
+    std::vector<std::string> touched;
+    const char *p = data.data();
+    const char *end = p + data.size();
+    const char *payload = nullptr;
+    const char *next = nullptr;
+    uint32_t len = 0;
+    while (parse_record(p, end, payload, len, next)) {
+        replay(payload, payload + len, touched);
+        p = next;
+    }
+    for (size_t i = 0; i < touched.size(); ++i) {
+        bool seen = false;
+        for (size_t j = 0; j < i && !seen; ++j) seen = touched[j] == touched[i];
+        if (!seen) sync_path(touched[i]);
+    }
+    if (::truncate(file_name.c_str(), 0) != 0) return;
+}
@@ -1,81 +1,444 @@
 #include "include/log.h"
+#include "include/lz_codec.h"
+#include "include/output.h"
 #include <fstream>
+#include <cstdint>
+#include <unordered_map>
 
-LogManager::LogManager() : file("log.dat") {
+namespace {
+
+const size_t kFlushEntries = 256;
+const std::chrono::seconds kFlushInterval(1);
+
+// 活动区中未归档的记录超过 kRotateBytes 字节时，把其中最早的一段压缩归档；
+// 段长取整批写入条数的倍数，整批写入时归档后活动区恰好为空
+const int kRotateBytes = 1 << 20;
+const int kSegmentRecords =
+    kRotateBytes / static_cast<int>(sizeof(LogEntry)) / static_cast<int>(kFlushEntries) * static_cast<int>(kFlushEntries);
+const int kSegmentMagic = 0x4745534c;  // "LSEG"
+const int kArchiveHeader = 3 * sizeof(int);
+
+void put_varint(std::string &out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+bool get_varint(const std::string &in, size_t &cursor, uint32_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 35 && cursor < in.size(); shift += 7) {
+        unsigned char b = static_cast<unsigned char>(in[cursor++]);
+        v |= static_cast<uint32_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// 把 [src, src + len) 复制进定长字段，保证以 '\0' 结尾
+void copy_field(char *dst, size_t cap, const char *src, size_t len) {
+    if (len >= cap) len = cap - 1;
+    std::memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+// 倒排表中第 ordinal 条记录 e 对应的值
+int posting_value(const LogEntry &e, int ordinal) {
+    return ordinal * 2 + (std::strcmp(e.type, "FIN") == 0 ? 1 : 0);
+}
+
+}  // namespace
+
+LogManager::LogManager()
+    : file("log.dat", RiverMode::Mapped), archive("log.seg", RiverMode::Mapped),
+      manifest("log.mft", RiverMode::Mapped),
+      employee_index("employee.idx"), postings("log.idx"), last_flush(std::chrono::steady_clock::now()) {
+#ifdef BOOKSTORE_LOG_FLUSH_EACH_COMMAND
+    flush_each_command = true;
+#endif
     std::ifstream fin("log.dat", std::ios::binary);
     if (!fin.good()) {
         file.initialise();
         file.write_info(0, 1);
     }
     fin.close();
+    std::ifstream fseg("log.seg", std::ios::binary);
+    if (!fseg.good()) {
+        archive.initialise();
+        archive.write_info(kArchiveHeader, 3);
+    }
+    fseg.close();
+    // 清单缺失（首次运行或旧版数据），或段数、记录数、条目数与 log.seg 不符（没有写完或格式不同）时重建
+    std::ifstream fmft("log.mft", std::ios::binary);
+    bool has_manifest = fmft.good();
+    fmft.close();
+    int segments = 0, archived = 0, listed = 0, listed_records = 0;
+    archive.get_info(segments, 1);
+    archive.get_info(archived, 2);
+    manifest.get_info(listed, 1);
+    manifest.get_info(listed_records, 2);
+    if (!has_manifest || listed != segments || listed_records != archived || manifest.slot_count() != segments) {
+        rebuild_manifest();
+    }
+
+    // 计数文件或倒排索引缺失（首次运行或旧版数据）或没有重建完时从日志重建；
+    // 倒排表的位置存在计数文件中，两者总是一起重建
+    if (!employee_index.complete() || !postings.complete()) rebuild_log_indexes();
+    buffer.reserve(kFlushEntries);
 }
 
-void LogManager::record_sys(const std::string &user, const std::string &action) {
-    LogEntry e;
-    std::strncpy(e.user, user.c_str(), 30);
-    std::strncpy(e.type, "SYS", 7);
-    std::strncpy(e.action, action.c_str(), 127);
+void LogManager::attach_journal(Journal &journal) {
+    file.set_journal(&journal);
+    archive.set_journal(&journal);
+    manifest.set_journal(&journal);
+    employee_index.set_journal(&journal);
+    postings.set_journal(&journal);
+}
 
-    file.write(e);
+// 清单缺失（旧版数据）或没有写完时沿 log.seg 的段头重建
+void LogManager::rebuild_manifest() {
+    manifest.initialise();
+    int segments = 0;
+    archive.get_info(segments, 1);
+    LogSegmentInfo info;
+    info.offset = kArchiveHeader;
+    info.first = 0;
+    LogSegmentHeader header;
+    std::vector<LogSegmentInfo> infos;
+    for (int i = 0; i < segments; ++i) {
+        archive.read_bytes(&header, info.offset, sizeof(header));
+        info.records = header.records;
+        infos.push_back(info);
+        info.first += header.records;
+        info.offset += static_cast<int>(sizeof(header)) + header.comp_len;
+    }
+    manifest.append_range(infos.data(), segments);
+    manifest.write_info(segments, 1);
+    manifest.write_info(info.first, 2);
+    manifest.sync();
+}
 
-    int cnt = 0;
+bool LogManager::segment_info(int i, LogSegmentInfo &info) {
+    int segments = 0;
+    manifest.get_info(segments, 1);
+    if (i < 0 || i >= segments) return false;
+    manifest.read_range(i, 1, &info);
+    return true;
+}
+
+int LogManager::record_count() {
+    int cnt = 0, sealed = 0, archived = 0;
     file.get_info(cnt, 1);
-    file.write_info(cnt + 1, 1);
+    file.get_info(sealed, 2);
+    archive.get_info(archived, 2);
+    return archived + cnt - sealed;
 }
 
-void LogManager::record_fin(const std::string &user, const std::string &action) {
+// 一条记录计入所属用户的计数，并追加到该用户的倒排表；value 见 posting_value
+void LogManager::add_record(EmployeeCounter &counter, int value) {
+    if (value % 2) ++counter.fin;
+    else ++counter.sys;
+    postings.append(counter.postings, value);
+}
+
+// 计数在内存中按用户累计（用户数远少于记录数），倒排表边读边追加
+void LogManager::rebuild_log_indexes() {
+    employee_index.initialise();
+    postings.initialise();
+    std::map<std::string, EmployeeCounter> counts;
+    LogReader reader(*this);
     LogEntry e;
+    for (int ordinal = 0; reader.next(e); ++ordinal) {
+        EmployeeCounter &c = counts.insert(std::make_pair(std::string(e.user), EmployeeCounter())).first->second;
+        int value = posting_value(e, ordinal);
+        add_record(c, value);
+        postings.append_global(value % 2, value);
+    }
+    for (auto &p : counts) employee_index.insert(FixedString<30>(p.first), p.second);
+    postings.mark_complete();
+    employee_index.mark_complete();
+}
+
+void LogManager::append(const std::string &user, const char *type, const std::string &action) {
+    buffer.push_back(LogEntry());
+    LogEntry &e = buffer.back();
     std::strncpy(e.user, user.c_str(), 30);
-    std::strncpy(e.type, "FIN", 7);
+    std::strncpy(e.type, type, 7);
     std::strncpy(e.action, action.c_str(), 127);
+    if (buffer.size() >= kFlushEntries) flush();
+}
 
-    file.write(e);
+void LogManager::record_sys(const std::string &user, const std::string &action) {
+    append(user, "SYS", action);
+}
 
-    int cnt = 0;
-    file.get_info(cnt, 1);
-    file.write_info(cnt + 1, 1);
+void LogManager::record_fin(const std::string &user, const std::string &action) {
+    append(user, "FIN", action);
+}
+
+void LogManager::end_command() {
+    if (buffer.empty()) return;
+    if (flush_each_command || std::chrono::steady_clock::now() - last_flush >= kFlushInterval) flush();
 }
 
-void LogManager::show_log() {
+// 缓冲区中的记录一次写到文件末尾，再更新记录数
+void LogManager::flush() {
+    last_flush = std::chrono::steady_clock::now();
+    if (buffer.empty()) return;
+    int first = record_count();
+
     int cnt = 0;
     file.get_info(cnt, 1);
+    file.write_range(cnt, static_cast<int>(buffer.size()), buffer.data());
+    file.write_info(cnt + static_cast<int>(buffer.size()), 1);
 
-    std::cout << "LOG\n";
-    for (int i = 1; i <= cnt; ++i) {
-        int pos = 2 * sizeof(int) + (i - 1) * sizeof(LogEntry);
-        LogEntry e;
-        file.read(e, pos);
-        std::cout << e.user << " " << e.type << " " << e.action << "\n";
+    // 全局表按序号顺序追加；同一批中同一用户的计数与倒排表合并后一次写回
+    std::map<std::string, std::vector<int>> batch;
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        int value = posting_value(buffer[i], first + static_cast<int>(i));
+        postings.append_global(value % 2, value);
+        batch[buffer[i].user].push_back(value);
+    }
+    for (auto &p : batch) {
+        const FixedString<30> user(p.first);
+        EmployeeCounter counter;
+        bool found = employee_index.find(user, counter);
+        if (!found) counter = EmployeeCounter();
+        for (int value : p.second) add_record(counter, value);
+        if (found) employee_index.update(user, counter);
+        else employee_index.insert(user, counter);
     }
-    std::cout << "END\n";
+    buffer.clear();
+    seal_segment();
 }
 
-void LogManager::generate_employee_report() {
-    int cnt = 0;
+// 未归档的记录够一段时，把最早的 kSegmentRecords 条压缩后追加到 log.seg，并在清单中登记。
+// 每次最多归档一段，旧版留下的长日志会在之后的写入中逐段归档；
+// 剩余的未归档记录不足一段时搬到 log.dat 开头并截短文件，已归档的记录不再重复占用空间。
+void LogManager::seal_segment() {
+    int cnt = 0, sealed = 0;
     file.get_info(cnt, 1);
+    file.get_info(sealed, 2);
+    if (cnt - sealed < kSegmentRecords) return;
+
+    std::vector<LogEntry> entries(kSegmentRecords);
+    file.read_range(sealed, kSegmentRecords, entries.data());
+
+    std::vector<std::string> dict;
+    std::unordered_map<std::string, uint32_t> ids;
+    auto id_of = [&](const char *field, size_t cap) {
+        std::string key(field, strnlen(field, cap));
+        auto it = ids.find(key);
+        if (it != ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(dict.size());
+        ids.emplace(key, id);
+        dict.push_back(key);
+        return id;
+    };
+    LogSegmentInfo info;
+    std::string body;
+    for (const LogEntry &e : entries) {
+        put_varint(body, id_of(e.user, sizeof(e.user)));
+        put_varint(body, id_of(e.type, sizeof(e.type)));
+        size_t len = strnlen(e.action, sizeof(e.action));
+        put_varint(body, static_cast<uint32_t>(len));
+        body.append(e.action, len);
+    }
+    std::string raw;
+    put_varint(raw, static_cast<uint32_t>(dict.size()));
+    for (const std::string &word : dict) {
+        put_varint(raw, static_cast<uint32_t>(word.size()));
+        raw += word;
+    }
+    raw += body;
+
+    std::string comp;
+    lz_compress(raw.data(), raw.size(), comp);
+    LogSegmentHeader header;
+    header.magic = kSegmentMagic;
+    header.records = kSegmentRecords;
+    header.raw_len = static_cast<int>(raw.size());
+    header.comp_len = static_cast<int>(comp.size());
+
+    int end = 0, segments = 0, archived = 0;
+    archive.get_info(end, 3);
+    archive.get_info(segments, 1);
+    archive.get_info(archived, 2);
+    archive.update_bytes(&header, end, sizeof(header));
+    archive.update_bytes(comp.data(), end + static_cast<int>(sizeof(header)), header.comp_len);
+    archive.write_info(end + static_cast<int>(sizeof(header)) + header.comp_len, 3);
+    archive.write_info(segments + 1, 1);
+    archive.write_info(archived + kSegmentRecords, 2);
+
+    info.offset = end;
+    info.first = archived;
+    info.records = kSegmentRecords;
+    manifest.write(info);
+    manifest.write_info(segments + 1, 1);
+    manifest.write_info(archived + kSegmentRecords, 2);
+
+    sealed += kSegmentRecords;
+    int rest = cnt - sealed;
+    if (rest >= kSegmentRecords) {
+        file.write_info(sealed, 2);
+        return;
+    }
+    if (rest > 0) {
+        std::vector<LogEntry> tail(rest);
+        file.read_range(sealed, rest, tail.data());
+        file.write_range(0, rest, tail.data());
+    }
+    file.truncate(rest);
+    file.write_info(rest, 1);
+    file.write_info(0, 2);
+}
+
+LogReader::LogReader(LogManager &manager)
+    : manager(manager), segments(0), archived(0), active_start(active_info(manager, 2)),
+      active(manager.file.scan(active_start, active_info(manager, 1))) {
+    manager.manifest.get_info(segments, 1);
+    manager.manifest.get_info(archived, 2);
+}
+
+// log.dat 的第 n 个 info：1 为记录数，2 为已归档的记录数
+int LogReader::active_info(LogManager &manager, int n) {
+    int value = 0;
+    manager.file.get_info(value, n);
+    return value;
+}
 
-    std::map<std::string, int> sys_cnt;
-    std::map<std::string, int> fin_cnt;
+// 一次读入第 segment_index 段的段头和压缩数据，解压后解析出字典
+bool LogReader::load_segment() {
+    LogSegmentInfo info;
+    loaded = segment_index++;
+    records_left = 0;
+    if (!manager.segment_info(loaded, info)) return false;
+    LogSegmentHeader header;
+    manager.archive.read_bytes(&header, info.offset, sizeof(header));
+    if (header.magic != kSegmentMagic || header.comp_len < 0 || header.raw_len < 0) return false;
+    std::string block(sizeof(header) + header.comp_len, '\0');
+    manager.archive.read_bytes(&block[0], info.offset, static_cast<int>(block.size()));
+    if (!lz_decompress(block.data() + sizeof(header), header.comp_len, header.raw_len, raw)) return false;
 
-    for (int i = 1; i <= cnt; ++i) {
-        int pos = 2 * sizeof(int) + (i - 1) * sizeof(LogEntry);
-        LogEntry e;
-        file.read(e, pos);
-        if (std::string(e.type) == "FIN") fin_cnt[e.user]++;
-        else sys_cnt[e.user]++;
+    cursor = 0;
+    dict.clear();
+    uint32_t words = 0, len = 0;
+    if (!get_varint(raw, cursor, words)) return false;
+    for (uint32_t i = 0; i < words; ++i) {
+        if (!get_varint(raw, cursor, len) || raw.size() - cursor < len) return false;
+        dict.push_back(raw.substr(cursor, len));
+        cursor += len;
     }
+    records_left = header.records;
+    return true;
+}
+
+// 解析当前归档段中的下一条记录，e 为空时只跳过
+bool LogReader::decode(LogEntry *e) {
+    uint32_t user = 0, type = 0, len = 0;
+    if (!get_varint(raw, cursor, user) || !get_varint(raw, cursor, type) || !get_varint(raw, cursor, len) ||
+        user >= dict.size() || type >= dict.size() || raw.size() - cursor < len) {
+        // 段内数据损坏：跳过该段剩余的记录
+        records_left = 0;
+        return false;
+    }
+    --records_left;
+    if (e != nullptr) {
+        *e = LogEntry();
+        copy_field(e->user, sizeof(e->user), dict[user].data(), dict[user].size());
+        copy_field(e->type, sizeof(e->type), dict[type].data(), dict[type].size());
+        copy_field(e->action, sizeof(e->action), raw.data() + cursor, len);
+    }
+    cursor += len;
+    return true;
+}
+
+bool LogReader::next(LogEntry &e) {
+    while (records_left > 0 || segment_index < segments) {
+        if (records_left == 0) {
+            load_segment();
+            continue;
+        }
+        if (decode(&e)) {
+            ++next_ordinal;
+            return true;
+        }
+    }
+    if (active.next(e)) {
+        ++next_ordinal;
+        return true;
+    }
+    return false;
+}
+
+void LogReader::seek(int ordinal) {
+    if (ordinal >= archived) {
+        segment_index = segments;
+        records_left = 0;
+        active.seek(active_start + (ordinal - archived));
+        next_ordinal = ordinal;
+        return;
+    }
+    // 在清单中二分查找包含 ordinal 的段
+    LogSegmentInfo info;
+    int lo = 0, hi = segments - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        manager.segment_info(mid, info);
+        if (info.first <= ordinal) lo = mid;
+        else hi = mid - 1;
+    }
+    active.seek(active_start);
+    if (lo != loaded || ordinal < next_ordinal || records_left == 0) {
+        manager.segment_info(lo, info);
+        segment_index = lo;
+        load_segment();
+        next_ordinal = info.first;
+    }
+    while (next_ordinal < ordinal && records_left > 0 && decode(nullptr)) ++next_ordinal;
+}
+
+void LogManager::show_log(const LogFilter &filter) {
+    flush();
+    int total = record_count();
+    if (filter.last > total) {
+        output() << "Invalid\n";
+        return;
+    }
+    // 换算成 0_base 的闭区间
+    int lo = filter.last >= 0 ? total - filter.last : filter.from - 1;
+    int hi = filter.last >= 0 ? total - 1 : std::min(filter.to, total) - 1;
 
-    std::vector<std::string> users;
-    for (auto &p : sys_cnt) users.push_back(p.first);
-    for (auto &p : fin_cnt) users.push_back(p.first);
-    std::sort(users.begin(), users.end());
-    users.erase(std::unique(users.begin(), users.end()), users.end());
+    LogReader reader(*this);
+    LogEntry e;
+    auto print = [&]() { output() << e.user << " " << e.type << " " << e.action << "\n"; };
 
-    std::cout << "EMPLOYEE REPORT\n";
-    for (auto &u : users) {
-        int s = sys_cnt[u];
-        int f = fin_cnt[u];
-        std::cout << u << " " << s << " " << f << " " << (s + f) << "\n";
+    output() << "LOG\n";
+    if (lo <= hi && filter.user.empty() && filter.type.empty()) {
+        reader.seek(lo);
+        for (int i = lo; i <= hi && reader.next(e); ++i) print();
+    } else if (lo <= hi) {
+        // 按用户（或类型）的倒排表只读命中的记录
+        int want_fin = filter.type.empty() ? -1 : (filter.type == "FIN" ? 1 : 0);
+        PostingList list;
+        EmployeeCounter counter;
+        if (filter.user.empty()) list = postings.global(want_fin);
+        else if (employee_index.find(FixedString<30>(filter.user), counter)) list = counter.postings;
+        postings.for_range(list, lo * 2, hi * 2 + 1, [&](int value) {
+            if (want_fin >= 0 && value % 2 != want_fin) return;
+            reader.seek(value / 2);
+            if (reader.next(e)) print();
+        });
     }
-    std::cout << "END\n";
+    output() << "END\n";
+}
+
+void LogManager::generate_employee_report() {
+    flush();
+    output() << "EMPLOYEE REPORT\n";
+    employee_index.for_each([](const FixedString<30> &user, const EmployeeCounter &c) {
+        output() << user.str << " " << c.sys << " " << c.fin << " " << (c.sys + c.fin) << "\n";
+    });
+    output() << "END\n";
 }
@@ -0,0 +1,105 @@
+#include "include/lz_codec.h"
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+const int kMinMatch = 4;
+const int kHashBits = 12;
+const size_t kMaxDistance = 65535;
+
+uint32_t read32(const char *p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+size_t hash4(const char *p) {
+    return (read32(p) * 2654435761u) >> (32 - kHashBits);
+}
+
+void put_length(std::string &out, size_t len) {
+    while (len >= 255) {
+        out.push_back(static_cast<char>(255));
+        len -= 255;
+    }
+    out.push_back(static_cast<char>(len));
+}
+
+// 写出一个序列：literal_len 个字面量，之后（match_len > 0 时）是一个匹配
+void put_sequence(std::string &out, const char *literals, size_t literal_len,
+                  size_t distance, size_t match_len) {
+    size_t lit_code = literal_len < 15 ? literal_len : 15;
+    size_t match_code = 0;
+    if (match_len > 0) match_code = match_len - kMinMatch < 15 ? match_len - kMinMatch : 15;
+    out.push_back(static_cast<char>((lit_code << 4) | match_code));
+    if (lit_code == 15) put_length(out, literal_len - 15);
+    out.append(literals, literal_len);
+    if (match_len == 0) return;
+    out.push_back(static_cast<char>(distance & 0xff));
+    out.push_back(static_cast<char>(distance >> 8));
+    if (match_code == 15) put_length(out, match_len - kMinMatch - 15);
+}
+
+bool take_length(const unsigned char *&p, const unsigned char *end, size_t &len) {
+    while (true) {
+        if (p == end) return false;
+        unsigned char b = *p++;
+        len += b;
+        if (b != 255) return true;
+    }
+}
+
+}  // namespace
+
+void lz_compress(const char *src, size_t len, std::string &out) {
+    out.clear();
+    std::vector<int> table(1u << kHashBits, -1);
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + kMinMatch <= len) {
+        size_t h = hash4(src + i);
+        int candidate = table[h];
+        table[h] = static_cast<int>(i);
+        if (candidate < 0 || i - candidate > kMaxDistance ||
+            read32(src + candidate) != read32(src + i)) {
+            ++i;
+            continue;
+        }
+        size_t match_len = kMinMatch;
+        while (i + match_len < len && src[candidate + match_len] == src[i + match_len]) ++match_len;
+        put_sequence(out, src + anchor, i - anchor, i - candidate, match_len);
+        i += match_len;
+        anchor = i;
+    }
+    put_sequence(out, src + anchor, len - anchor, 0, 0);
+}
+
+bool lz_decompress(const char *src, size_t len, size_t raw_len, std::string &out) {
+    out.clear();
+    out.reserve(raw_len);
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(src);
+    const unsigned char *end = p + len;
+    while (p < end) {
+        unsigned char token = *p++;
+        size_t literal_len = token >> 4;
+        if (literal_len == 15 && !take_length(p, end, literal_len)) return false;
+        if (static_cast<size_t>(end - p) < literal_len || out.size() + literal_len > raw_len) return false;
+        out.append(reinterpret_cast<const char *>(p), literal_len);
+        p += literal_len;
+        if (p == end) break;  // 最后一个序列
+
+        if (end - p < 2) return false;
+        size_t distance = p[0] | (static_cast<size_t>(p[1]) << 8);
+        p += 2;
+        size_t match_len = (token & 15);
+        if (match_len == 15 && !take_length(p, end, match_len)) return false;
+        match_len += kMinMatch;
+        if (distance == 0 || distance > out.size() || out.size() + match_len > raw_len) return false;
+        // 匹配可能与自身重叠，逐字节复制
+        size_t from = out.size() - distance;
+        for (size_t k = 0; k < match_len; ++k) out.push_back(out[from + k]);
+    }
+    return out.size() == raw_len;
+}
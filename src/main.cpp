@@ -2,6 +2,9 @@
 #include "include/application.h"
 
 int main() {
+    // 输出全部经由 output()，标准输入不再需要与 stdio 同步
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
     Application app;
     app.run();
     return 0;
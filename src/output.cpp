@@ -0,0 +1,113 @@
+#include "include/output.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include <unistd.h>
+
+Output::Output() : buffer(new char[kCapacity]) {}
+
+Output::~Output() {
+    flush();
+    delete[] buffer;
+}
+
+void Output::write(const char *s, size_t n) {
+    if (used + n > kCapacity) {
+        flush();
+        if (n > kCapacity) {
+            // 超过缓冲区的大块直接写出
+            while (n > 0) {
+                ssize_t w = ::write(1, s, n);
+                if (w <= 0) return;
+                s += w;
+                n -= w;
+            }
+            return;
+        }
+    }
+    std::memcpy(buffer + used, s, n);
+    used += n;
+}
+
+void Output::flush() {
+    const char *p = buffer;
+    while (used > 0) {
+        ssize_t w = ::write(1, p, used);
+        if (w <= 0) break;
+        p += w;
+        used -= w;
+    }
+    used = 0;
+}
+
+Output &Output::operator<<(const char *s) {
+    write(s, std::strlen(s));
+    return *this;
+}
+
+Output &Output::operator<<(const std::string &s) {
+    write(s.data(), s.size());
+    return *this;
+}
+
+Output &Output::operator<<(char c) {
+    if (used == kCapacity) flush();
+    buffer[used++] = c;
+    return *this;
+}
+
+Output &Output::operator<<(int v) {
+    return *this << static_cast<long long>(v);
+}
+
+Output &Output::operator<<(long long v) {
+    char digits[24];
+    int n = 0;
+    // 取负数的绝对值时用无符号运算，避免最小值溢出
+    unsigned long long u = v < 0 ? 0ull - static_cast<unsigned long long>(v) : v;
+    do {
+        digits[n++] = static_cast<char>('0' + u % 10);
+        u /= 10;
+    } while (u > 0);
+    if (v < 0) digits[n++] = '-';
+    char text[24];
+    for (int i = 0; i < n; ++i) text[i] = digits[n - 1 - i];
+    write(text, n);
+    return *this;
+}
+
+// 与 printf("%.2f") 一致：按二进制的精确值舍入，恰好一半时取偶。
+// 整数部分与小数部分分开算，小数部分乘 100 在 64 位尾数的 long double 中是精确的；
+// 不满足这一前提（超大数、非有限值或 long double 精度不足）时退回 snprintf。
+Output &Output::operator<<(Fixed2 f) {
+    double v = f.value;
+    const double kLimit = 9007199254740992.0 / 100;  // 2^53 / 100
+    if (!std::isfinite(v) || std::fabs(v) >= kLimit || std::numeric_limits<long double>::digits < 64) {
+        // 最大的 double 有 309 位整数，连同符号、小数点和两位小数不超过 320 字节
+        char text[320];
+        int n = std::snprintf(text, sizeof(text), "%.2f", v);
+        if (n > 0) write(text, std::min(static_cast<size_t>(n), sizeof(text) - 1));
+        return *this;
+    }
+    if (std::signbit(v)) *this << '-';
+    double mag = std::fabs(v);
+    double whole = std::floor(mag);
+    long double scaled = static_cast<long double>(mag - whole) * 100;
+    long double low = std::floor(scaled);
+    long double rest = scaled - low;
+    long long cents = static_cast<long long>(low);
+    if (rest > 0.5L || (rest == 0.5L && (cents & 1))) ++cents;
+    long long units = static_cast<long long>(whole) + cents / 100;
+    cents %= 100;
+    *this << units << '.';
+    *this << static_cast<char>('0' + cents / 10) << static_cast<char>('0' + cents % 10);
+    return *this;
+}
+
+Output &output() {
+    static Output instance;
+    return instance;
+}
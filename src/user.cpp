@@ -2,6 +2,12 @@
 
 #include <cstring>
 #include <cctype>
+#include <vector>
+
+static const int HEADER = 2 * sizeof(int);
+
+// 空洞超过槽位数一半（且文件不太小）时压缩 users.dat
+static const int COMPACT_MIN_SLOTS = 64;
 
 User::User() {
     std::memset(user_id, 0, sizeof(user_id));
@@ -22,9 +28,15 @@ User::User(const std::string &uid, const std::string &pwd,
 }
 
 AccountManager::AccountManager()
-    : user_file("users.dat") {
+    : user_file("users.dat", RiverMode::Mapped), user_index("users.idx") {
+}
+
+void AccountManager::attach_journal(Journal &journal) {
+    user_file.set_journal(&journal);
+    user_index.set_journal(&journal);
 }
 
+// 只在 users.dat 不存在或连一条完整记录都没有时调用，不会丢失已有账户
 void AccountManager::rebuild_users_file() {
     const char* FN = "users.dat";
     user_file.initialise(FN);
@@ -33,14 +45,73 @@ void AccountManager::rebuild_users_file() {
     User root("root", "sjtu", "Super Admin", 7);
     user_file.write(root);
     user_file.write_info(1, 1);
+    user_file.sync();
+
+    rebuild_user_index();
 }
 
+// 文件头的槽位数与文件长度不符（文件头没来得及落盘）时，以文件中实际的记录为准：
+// 重新计数，空槽位重新串成空闲链表，再重建索引
+void AccountManager::repair_users_file() {
+    int slots = user_file.slot_count();
+    std::vector<int> empty;
+    user_file.for_each(0, slots, [](const User &user) { return user.user_id[0] == '\0'; },
+                       [&](const User &, int pos) { empty.push_back(pos); });
+    user_file.write_info(slots, 1);
+    user_file.write_info(0, 2);
+    for (int pos : empty) user_file.Delete(pos);
+    user_file.sync();
+    rebuild_user_index();
+}
 
-void AccountManager::initialize() {
+// 按 users.dat 的当前内容重建 user_id 索引
+void AccountManager::rebuild_user_index() {
+    user_index.initialise();
+
+    int n = 0;
+    user_file.get_info(n, 1);
+    user_file.for_each(0, n, [](const User &user) { return user.user_id[0] != '\0'; },
+                       [&](const User &user, int pos) { user_index.insert(UserKey(user.user_id), pos); });
+    user_index.mark_complete();
+}
+
+// 旧版 users.dat 只有一个 int 的文件头，读出全部记录后按新格式写入临时文件，
+// 原来的删除标记转为空闲槽位；落盘后再替换旧文件
+void AccountManager::upgrade_users_file() {
     const char *FN = "users.dat";
-    const int HEADER = sizeof(int);
+    std::ifstream fin(FN, std::ios::binary);
+    int n = 0;
+    fin.read(reinterpret_cast<char *>(&n), sizeof(int));
+    std::vector<User> users;
+    User tmp;
+    for (int i = 0; i < n && fin.read(reinterpret_cast<char *>(&tmp), sizeof(User)); ++i) {
+        users.push_back(tmp);
+    }
+    fin.close();
+
+    user_file.initialise(std::string(FN) + ".tmp");
+    user_file.append_range(users.data(), static_cast<int>(users.size()));
+    for (int i = 0; i < static_cast<int>(users.size()); ++i) {
+        if (users[i].user_id[0] == '\0') user_file.Delete(user_file.record_pos(i));
+    }
+    user_file.write_info(static_cast<int>(users.size()), 1);
+    user_file.replace(FN);
+    rebuild_user_index();
+}
+
+// 写入新用户（优先复用空闲槽位），槽位数只在追加到末尾时增加
+int AccountManager::append_user(User &user) {
+    int n = 0;
+    user_file.get_info(n, 1);
+    int pos = user_file.write(user);
+    if (pos >= user_file.record_pos(n)) user_file.write_info(n + 1, 1);
+    user_index.insert(UserKey(user.user_id), pos);
+    return pos;
+}
 
-    bool need_init = false;
+
+void AccountManager::initialize() {
+    const char *FN = "users.dat";
 
     // 文件不存在需要初始化
     std::ifstream fin;
@@ -60,22 +131,30 @@ void AccountManager::initialize() {
         return;
     }
 
-    int n = 0;
-    user_file.get_info(n, 1);
-    if (n == 0) {
-        rebuild_users_file();
-        return;
+    bool repaired = false;
+    if ((sz - static_cast<std::streamoff>(sizeof(int))) % static_cast<std::streamoff>(sizeof(User)) == 0) {
+        upgrade_users_file();
+        repaired = true;
+    } else {
+        int n = 0;
+        user_file.get_info(n, 1);
+        if (n != user_file.slot_count()) {
+            repair_users_file();
+            repaired = true;
+        }
     }
 
-    // 验证第一条是否是 root
-    User first;
-    user_file.read(first, HEADER);
+    // 索引文件缺失（旧版数据）或没有重建完时从 users.dat 重建
+    if (!repaired && !user_index.complete()) rebuild_user_index();
 
-    if (std::strcmp(first.user_id, "root") != 0 ||
-        first.privilege != 7) {
-        rebuild_users_file();
-        return;
-        }
+    // root 账户丢失时补上，已有账户一律保留
+    User root;
+    int pos = 0;
+    if (!find_user("root", root, pos)) {
+        User new_root("root", "sjtu", "Super Admin", 7);
+        append_user(new_root);
+        user_file.sync();
+    }
 }
 
 bool AccountManager::validate_string(const std::string &str, bool allow_quotes) {
@@ -97,25 +176,18 @@ bool AccountManager::validate_string(const std::string &str, bool allow_quotes)
 }
 
 bool AccountManager::find_user(const std::string &id, User &user, int &index) {
-    int n = 0;
-    user_file.get_info(n, 1);
-
-    for (int i = 1; i <= n; ++i) {
-        const int HEADER = sizeof(int);
-        int pos = HEADER + (i - 1) * sizeof(User);
+    if (id.empty() || id.size() > 30) return false;
 
-        User tmp;
-        user_file.read(tmp, pos);
+    int pos = 0;
+    if (!user_index.find(UserKey(id), pos)) return false;
 
-        if (tmp.user_id[0] == '\0') continue; // 跳过已删除用户
+    User tmp;
+    user_file.read(tmp, pos);
+    if (std::strcmp(id.c_str(), tmp.user_id) != 0) return false;
 
-        if (std::strcmp(id.c_str(), tmp.user_id) == 0) {
-            user = tmp;
-            index = pos;
-            return true;
-        }
-    }
-    return false;
+    user = tmp;
+    index = pos;
+    return true;
 }
 
 bool AccountManager::register_user(const std::string &user_id,
@@ -131,11 +203,7 @@ bool AccountManager::register_user(const std::string &user_id,
     if (find_user(user_id, tmp, idx)) return false;
 
     User new_user(user_id, password, user_name, 1);
-
-    int n = 0;
-    user_file.get_info(n, 1);
-    user_file.write(new_user);
-    user_file.write_info(n + 1, 1);
+    append_user(new_user);
 
     return true;
 }
@@ -199,11 +267,7 @@ bool AccountManager::useradd(const std::string &user_id,
     if (find_user(user_id, tmp, idx)) return false;
 
     User new_user(user_id, password, user_name, privilege);
-
-    int n = 0;
-    user_file.get_info(n, 1);
-    user_file.write(new_user);
-    user_file.write_info(n + 1, 1);
+    append_user(new_user);
 
     return true;
 }
@@ -213,9 +277,20 @@ bool AccountManager::delete_user(const std::string &user_id) {
     int idx = 0;
     if (!find_user(user_id, user, idx)) return false;
 
-    // 标记删除
-    user.user_id[0] = '\0';
-    user_file.update(user, idx);
-    
+    // 槽位挂入空闲链表，供之后的注册复用
+    user_index.erase(UserKey(user_id));
+    user_file.Delete(idx);
+
+    int n = 0;
+    user_file.get_info(n, 1);
+    if (n >= COMPACT_MIN_SLOTS && user_file.free_count() * 2 > n) {
+        int live = user_file.compact([this](int, int to) {
+            User moved;
+            user_file.read(moved, to);
+            user_index.update(UserKey(moved.user_id), to);
+        });
+        user_file.write_info(live, 1);
+    }
+
     return true;
 }
\ No newline at end of file
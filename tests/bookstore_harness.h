@@ -0,0 +1,163 @@
+#pragma once
+// 端到端测试的公共部分：在临时目录中运行编译好的程序（路径由第一个参数给出），
+// 一次性喂入全部输入，或交互地逐条发送指令后用 kill -9 打断。
+// 每个测试程序只由一个源文件构成，这里的变量都是该程序私有的。
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+int failures = 0;
+std::string binary;
+std::string scratch;
+
+inline void check(bool ok, const std::string &what) {
+    if (ok) return;
+    ++failures;
+    std::printf("FAIL %s\n", what.c_str());
+}
+
+inline long file_size(const std::string &name) {
+    struct stat st;
+    return ::stat(name.c_str(), &st) == 0 ? static_cast<long>(st.st_size) : -1;
+}
+
+// 新建一个空的数据目录
+inline std::string fresh_dir(const std::string &name) {
+    std::string dir = scratch + "/" + name;
+    std::system(("rm -rf " + dir).c_str());
+    ::mkdir(dir.c_str(), 0755);
+    return dir;
+}
+
+inline int file_count(const std::string &dir) {
+    int n = 0;
+    DIR *d = ::opendir(dir.c_str());
+    if (d == nullptr) return -1;
+    while (dirent *e = ::readdir(d)) {
+        if (std::strcmp(e->d_name, ".") != 0 && std::strcmp(e->d_name, "..") != 0) ++n;
+    }
+    ::closedir(d);
+    return n;
+}
+
+inline std::string join(const std::vector<std::string> &lines, size_t first = 0, size_t last = std::string::npos) {
+    std::string s;
+    for (size_t i = first; i < lines.size() && i < last; ++i) s += lines[i] + "\n";
+    return s;
+}
+
+// 在 dir 中运行一次程序，input 为全部标准输入，返回标准输出
+inline std::string run(const std::string &dir, const std::string &input) {
+    std::string in_file = scratch + "/stdin.txt", out_file = scratch + "/stdout.txt";
+    std::ofstream(in_file.c_str(), std::ios::binary) << input;
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        int in = ::open(in_file.c_str(), O_RDONLY);
+        int out = ::open(out_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (in < 0 || out < 0 || ::chdir(dir.c_str()) != 0) ::_exit(127);
+        ::dup2(in, 0);
+        ::dup2(out, 1);
+        ::execl(binary.c_str(), binary.c_str(), static_cast<char *>(nullptr));
+        ::_exit(127);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    std::ifstream fin(out_file.c_str(), std::ios::binary);
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    return ss.str();
+}
+
+// 交互运行的程序：每条指令之后跟一条只输出空行的查询，读到空行即说明指令已处理完
+const char *const kProbe = "show -ISBN=PROBE";
+
+struct Live {
+    pid_t pid;
+    int in;
+    FILE *out;
+};
+
+inline Live start(const std::string &dir) {
+    int to_child[2], from_child[2];
+    Live live = {-1, -1, nullptr};
+    if (::pipe(to_child) != 0 || ::pipe(from_child) != 0) return live;
+    live.pid = ::fork();
+    if (live.pid == 0) {
+        ::dup2(to_child[0], 0);
+        ::dup2(from_child[1], 1);
+        ::close(to_child[1]);
+        ::close(from_child[0]);
+        if (::chdir(dir.c_str()) != 0) ::_exit(127);
+        ::execl(binary.c_str(), binary.c_str(), static_cast<char *>(nullptr));
+        ::_exit(127);
+    }
+    ::close(to_child[0]);
+    ::close(from_child[1]);
+    live.in = to_child[1];
+    live.out = ::fdopen(from_child[0], "r");
+    return live;
+}
+
+inline void send(Live &live, const std::string &line) {
+    std::string s = line + "\n";
+    if (::write(live.in, s.data(), s.size()) != static_cast<ssize_t>(s.size())) check(false, "write to child");
+}
+
+// 发送一条指令并等它处理完
+inline bool send_acked(Live &live, const std::string &line) {
+    send(live, line);
+    send(live, kProbe);
+    char buf[4096];
+    while (std::fgets(buf, sizeof(buf), live.out) != nullptr) {
+        if (std::strcmp(buf, "\n") == 0) return true;
+    }
+    return false;
+}
+
+inline void kill_live(Live &live) {
+    ::kill(live.pid, SIGKILL);
+    ::waitpid(live.pid, nullptr, 0);
+    ::close(live.in);
+    std::fclose(live.out);
+}
+
+// 测试程序的 main：解析程序路径、建立临时目录，执行 body 后清理
+inline int harness_main(int argc, char **argv, const char *name, void (*body)()) {
+    if (argc < 2) {
+        std::printf("usage: %s <path to code>\n", name);
+        return 1;
+    }
+    char path[4096];
+    if (::realpath(argv[1], path) == nullptr) {
+        std::printf("cannot find %s\n", argv[1]);
+        return 1;
+    }
+    binary = path;
+    std::string pattern = std::string("/tmp/") + name + ".XXXXXX";
+    std::vector<char> dir(pattern.begin(), pattern.end());
+    dir.push_back('\0');
+    if (::mkdtemp(dir.data()) == nullptr) {
+        std::printf("cannot create a scratch directory\n");
+        return 1;
+    }
+    scratch = dir.data();
+    body();
+    std::system(("rm -rf " + scratch).c_str());
+    std::printf("%s: %s\n", name, failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+}  // namespace
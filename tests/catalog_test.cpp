@@ -0,0 +1,80 @@
+// 常驻目录（BOOKSTORE_RESIDENT_CATALOG=1）：同一串修改书目、穿插各种 show 查询的指令，
+// 开启与不开启常驻目录时的输出必须完全相同；重启后从 books.dat 重新载入目录也是如此。
+#include "bookstore_harness.h"
+
+#include <random>
+
+namespace {
+
+std::string pick(std::mt19937 &rng, const char *prefix, int range) {
+    return prefix + std::to_string(static_cast<int>(rng() % range));
+}
+
+// 改 ISBN、改文字、进货、购买（含失败的），每隔几条插入查询
+std::string catalog_workload(std::mt19937 &rng, int steps) {
+    std::string s = "su root sjtu\n";
+    for (int i = 0; i < steps; ++i) {
+        switch (rng() % 9) {
+            case 0:
+                s += "select " + pick(rng, "C", 80) + "\n";
+                break;
+            case 1:
+                s += "modify -ISBN=" + pick(rng, "C", 80) + "\n";
+                break;
+            case 2:
+                s += "modify -name=\"" + pick(rng, "N", 20) + "\" -author=\"" + pick(rng, "A", 10) + "\"\n";
+                break;
+            case 3:
+                s += "modify -keyword=\"" + pick(rng, "k", 12) + "|" + pick(rng, "q", 12) + "\" -price=" +
+                     std::to_string(static_cast<int>(rng() % 50)) + ".25\n";
+                break;
+            case 4:
+                s += "import " + std::to_string(static_cast<int>(rng() % 5 + 1)) + " 10\n";
+                break;
+            case 5:
+                s += "buy " + pick(rng, "C", 80) + " " + std::to_string(static_cast<int>(rng() % 3 + 1)) + "\n";
+                break;
+            case 6:
+                s += "show -name=\"" + pick(rng, "N", 20) + "\"\nshow -author=\"" + pick(rng, "A", 10) + "\"\n";
+                break;
+            case 7:
+                s += "show -keyword=\"" + pick(rng, rng() % 2 ? "k" : "q", 12) + "\"\nshow -ISBN=" +
+                     pick(rng, "C", 80) + "\n";
+                break;
+            default:
+                s += "show\n";
+                break;
+        }
+    }
+    return s + "exit\n";
+}
+
+std::string run_with_catalog(const std::string &dir, const std::string &input, bool resident) {
+    if (resident) ::setenv("BOOKSTORE_RESIDENT_CATALOG", "1", 1);
+    else ::unsetenv("BOOKSTORE_RESIDENT_CATALOG");
+    std::string out = run(dir, input);
+    ::unsetenv("BOOKSTORE_RESIDENT_CATALOG");
+    return out;
+}
+
+void test_resident_catalog() {
+    std::mt19937 rng(24);
+    std::string plain = fresh_dir("plain"), resident = fresh_dir("resident");
+    for (int part = 0; part < 3; ++part) {
+        std::string input = catalog_workload(rng, 600);
+        std::string expect = run_with_catalog(plain, input, false);
+        check(expect.find('\t') != std::string::npos, "catalog: workload shows books");
+        check(run_with_catalog(resident, input, true) == expect,
+              "catalog: same output as the indexes, part " + std::to_string(part));
+    }
+    // 不开启常驻目录时读到的是同样的数据
+    const std::string queries = "su root sjtu\nshow\nshow finance\nexit\n";
+    check(run_with_catalog(resident, queries, false) == run_with_catalog(plain, queries, false),
+          "catalog: data files match");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    return harness_main(argc, argv, "catalog", test_resident_catalog);
+}
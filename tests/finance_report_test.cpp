@@ -0,0 +1,71 @@
+// report finance：总收入、总支出与 show finance 一致，净利润等于二者以分相减，
+// 包括支出大于收入（净利润为负）和累计金额大到用 double 相减会差一分的账目。
+#include "bookstore_harness.h"
+
+namespace {
+
+long long cents_of(const std::string &text) {
+    size_t dot = text.find('.');
+    bool negative = !text.empty() && text[0] == '-';
+    long long units = std::atoll(text.substr(negative ? 1 : 0, dot - (negative ? 1 : 0)).c_str());
+    long long cents = units * 100 + std::atoi(text.substr(dot + 1).c_str());
+    return negative ? -cents : cents;
+}
+
+std::string text_of(long long cents) {
+    std::string sign = cents < 0 ? "-" : "";
+    if (cents < 0) cents = -cents;
+    char buf[40];
+    std::snprintf(buf, sizeof(buf), "%lld.%02lld", cents / 100, cents % 100);
+    return sign + buf;
+}
+
+// 取出以 label 开头的一行中 label 之后的部分
+std::string field(const std::string &out, const std::string &label) {
+    size_t at = out.find(label);
+    if (at == std::string::npos) return "";
+    at += label.size();
+    return out.substr(at, out.find('\n', at) - at);
+}
+
+// input 之后接 show finance 与 report finance，按 show finance 的结果核对报表
+void check_report(const std::string &dir, const std::string &input, const std::string &what) {
+    std::string out = run(dir, input + "show finance\nreport finance\nexit\n");
+    size_t plus = out.rfind("+ "), minus = out.find(" - ", plus);
+    check(plus != std::string::npos && minus != std::string::npos, what + ": show finance");
+    if (plus == std::string::npos || minus == std::string::npos) return;
+    std::string income = out.substr(plus + 2, minus - plus - 2);
+    std::string expense = out.substr(minus + 3, out.find('\n', minus) - minus - 3);
+    check(field(out, "总收入: ") == income, what + ": income");
+    check(field(out, "总支出: ") == expense, what + ": expense");
+    check(field(out, "净利润: ") == text_of(cents_of(income) - cents_of(expense)), what + ": net");
+}
+
+void test_finance_report() {
+    std::string dir = fresh_dir("small");
+    std::string input =
+        "su root sjtu\n"
+        "select F-1\n"
+        "modify -price=12.34\n"
+        "import 10 100.01\n"
+        "buy F-1 3\n"
+        "select F-2\n"
+        "modify -price=0.1\n"
+        "import 5 0.3\n"
+        "buy F-2 5\n";
+    check_report(dir, input, "small");
+    // 再进一批货，支出超过收入
+    check_report(dir, "su root sjtu\nselect F-1\nimport 100 9999.99\n", "negative net");
+
+    // 总支出约 2e14 元：分别转成 double 再相减，净利润会差一分
+    dir = fresh_dir("large");
+    input = "su root sjtu\nselect L-1\nmodify -price=0.03\n";
+    for (int i = 0; i < 20000; ++i) input += "import 1 9999999999.99\n";
+    check_report(dir, input + "buy L-1 7\n", "large ledger");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    return harness_main(argc, argv, "finance_report", test_finance_report);
+}
@@ -0,0 +1,143 @@
+// HashIndex 的回归测试：随机插入、改值、删除与 std::map 对照，覆盖桶分裂与目录加倍，
+// 重新打开后内容不变；新桶和新记录先清零，栈上的残留（先用 0xA5 填满栈）不会写进文件；
+// 文件头丢了目录时查找只报告找不到，不清空文件，并且 complete() 为假以便调用方重建。
+#include "include/hash_index.h"
+#include "include/fixed_string.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (ok) return;
+    ++failures;
+    std::printf("FAIL %s\n", what);
+}
+
+typedef FixedString<30> Key;
+typedef HashIndex<Key, int> Index;
+
+// 让之后的调用在布满 0xA5 的栈上运行，没有初始化的局部变量会带着这个图案
+__attribute__((noinline)) void poison_stack() {
+    volatile unsigned char junk[1 << 14];
+    for (size_t i = 0; i < sizeof(junk); ++i) junk[i] = 0xA5;
+}
+
+std::string key_of(int k) {
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "user_%d", k);
+    return buf;
+}
+
+long file_size(const char *name) {
+    struct stat st;
+    return ::stat(name, &st) == 0 ? static_cast<long>(st.st_size) : -1;
+}
+
+bool same_contents(Index &index, const std::map<std::string, int> &model, int key_range) {
+    bool ok = index.size() == static_cast<int>(model.size());
+    for (int k = 0; k < key_range; ++k) {
+        int value = 0;
+        std::map<std::string, int>::const_iterator it = model.find(key_of(k));
+        bool hit = index.find(Key(key_of(k)), value);
+        ok = ok && hit == (it != model.end()) && (!hit || value == it->second);
+    }
+    return ok;
+}
+
+void test_against_map() {
+    const int kKeys = 12000;
+    std::map<std::string, int> model;
+    std::mt19937 rng(4);
+    {
+        Index index("hash.idx");
+        index.initialise();
+        for (int step = 0; step < 30000; ++step) {
+            std::string key = key_of(static_cast<int>(rng() % kKeys));
+            int value = static_cast<int>(rng() % 1000000);
+            poison_stack();
+            switch (rng() % 4) {
+                case 0:
+                case 1:
+                    check(index.insert(Key(key), value) == model.insert(std::make_pair(key, value)).second,
+                          "insert result");
+                    break;
+                case 2:
+                    check(index.update(Key(key), value) == (model.count(key) != 0), "update result");
+                    if (model.count(key) != 0) model[key] = value;
+                    break;
+                default:
+                    check(index.erase(Key(key)) == (model.erase(key) != 0), "erase result");
+                    break;
+            }
+        }
+        check(same_contents(index, model, kKeys), "contents");
+        index.mark_complete();
+    }
+    Index index("hash.idx");
+    check(index.complete(), "complete after mark_complete");
+    check(same_contents(index, model, kKeys), "contents after reopen");
+
+    std::ifstream fin("hash.idx", std::ios::binary);
+    std::stringstream bytes;
+    bytes << fin.rdbuf();
+    check(bytes.str().find("\xA5\xA5") == std::string::npos, "no stack residue in the file");
+}
+
+void test_missing_directory() {
+    {
+        Index index("lost.idx");
+        index.initialise();
+        for (int k = 0; k < 500; ++k) index.insert(Key(key_of(k)), k);
+        index.mark_complete();
+    }
+    // 文件头的 info2（首个目录页位置）清零
+    long size = file_size("lost.idx");
+    int zero = 0;
+    std::fstream f("lost.idx", std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(sizeof(int));
+    f.write(reinterpret_cast<const char *>(&zero), sizeof(int));
+    f.close();
+
+    Index index("lost.idx");
+    int value = 0;
+    check(!index.complete(), "missing directory: not complete");
+    check(!index.find(Key(key_of(7)), value), "missing directory: find reports nothing");
+    check(index.size() == 0, "missing directory: size 0");
+    check(!index.insert(Key("new"), 1) && !index.update(Key(key_of(7)), 1) && !index.erase(Key(key_of(7))),
+          "missing directory: writes refused");
+    check(file_size("lost.idx") == size, "missing directory: file left untouched");
+
+    // 调用方重建后恢复正常
+    index.initialise();
+    for (int k = 0; k < 500; ++k) index.insert(Key(key_of(k)), k);
+    index.mark_complete();
+    check(index.complete() && index.find(Key(key_of(7)), value) && value == 7 && index.size() == 500,
+          "missing directory: usable after rebuild");
+}
+
+}  // namespace
+
+int main() {
+    char dir[] = "/tmp/hash_index_test.XXXXXX";
+    if (::mkdtemp(dir) == nullptr || ::chdir(dir) != 0) {
+        std::printf("cannot create a scratch directory\n");
+        return 1;
+    }
+    test_against_map();
+    test_missing_directory();
+    if (::chdir("/") == 0) std::system((std::string("rm -rf ") + dir).c_str());
+    if (failures == 0) std::printf("hash_index: ok\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Journal 的回归测试：子进程中提交事务后直接 _exit，进程内缓存里尚未写回的修改随之丢失，
+// 与被 kill -9 时相同；父进程重新打开日志，检查已提交的事务全部恢复、未提交的全部丢弃，
+// 日志末尾写了一半的记录被忽略。
+#include "include/MemoryRiver.h"
+#include "include/journal.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (ok) return;
+    ++failures;
+    std::printf("FAIL %s\n", what);
+}
+
+// 空闲链表的后继存放在槽位的最后一个 int 中
+struct Rec {
+    int key;
+    int payload[14];
+    int reserved;
+};
+
+Rec make(int key) {
+    Rec r;
+    r.key = key;
+    for (int i = 0; i < 14; ++i) r.payload[i] = key * 31 + i;
+    r.reserved = 0;
+    return r;
+}
+
+bool holds(MemoryRiver<Rec, 2, 2> &file, int pos, int key) {
+    Rec r;
+    file.read(r, pos);
+    return r.key == key && r.payload[13] == key * 31 + 13;
+}
+
+long file_size(const char *name) {
+    struct stat st;
+    return ::stat(name, &st) == 0 ? static_cast<long>(st.st_size) : -1;
+}
+
+// 子进程中执行的事务。缓存模式下截短会先写回缓存，所以截短的事务放在最前面
+void run_transactions() {
+    Journal journal("journal.dat");
+    MemoryRiver<Rec, 2, 2> file("replay.dat");
+    file.set_journal(&journal);
+    file.initialise();
+    for (int i = 0; i < 50; ++i) {
+        Rec r = make(i);
+        file.write(r);
+    }
+    file.write_info(50, 1);
+    journal.checkpoint();
+
+    // 1: 截掉最后 3 条，再追加 1 条
+    journal.begin();
+    file.truncate(47);
+    Rec tail = make(3000);
+    file.append_range(&tail, 1);
+    file.write_info(48, 1);
+    journal.commit();
+
+    // 2: 同一条记录反复改写、改写一段、删除一条
+    journal.begin();
+    for (int v = 0; v < 5; ++v) {
+        Rec r = make(1000 + v);
+        file.update(r, file.record_pos(10));
+    }
+    for (int i = 20; i < 30; ++i) {
+        Rec r = make(2000 + i);
+        file.update(r, file.record_pos(i));
+    }
+    file.Delete(file.record_pos(5));
+    journal.commit();
+
+    // 3: 没有提交
+    journal.begin();
+    Rec lost = make(4000);
+    file.update(lost, file.record_pos(0));
+    file.write_info(99, 1);
+    ::_exit(0);
+}
+
+void test_journal_replay() {
+    pid_t pid = ::fork();
+    if (pid == 0) run_transactions();
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    check(WIFEXITED(status), "replay: child exited");
+
+    // 已提交的修改只有截短落到了文件上，其余都留在子进程的缓存里
+    {
+        MemoryRiver<Rec, 2, 2> file("replay.dat");
+        check(file.slot_count() == 47 && holds(file, file.record_pos(10), 10),
+              "replay: committed writes still only in the child's cache");
+    }
+
+    // 日志末尾一条写了一半的记录，重放时应忽略
+    FILE *f = std::fopen("journal.dat", "ab");
+    std::fwrite("BTXN\xff\xff\x00\x00partial", 1, 15, f);
+    std::fclose(f);
+
+    { Journal journal("journal.dat"); }
+    check(file_size("journal.dat") == 0, "replay: journal emptied after recovery");
+
+    MemoryRiver<Rec, 2, 2> file("replay.dat");
+    int n = 0;
+    file.get_info(n, 1);
+    check(n == 48, "replay: header of the last committed transaction");
+    check(file.slot_count() == 48, "replay: truncate and append replayed in order");
+    check(file.free_count() == 1, "replay: deleted slot on the free list");
+    check(holds(file, file.record_pos(0), 0), "replay: uncommitted write discarded");
+    check(holds(file, file.record_pos(10), 1004), "replay: last of the repeated writes");
+    bool ok = true;
+    for (int i = 20; i < 30; ++i) ok = ok && holds(file, file.record_pos(i), 2000 + i);
+    for (int i = 30; i < 47; ++i) ok = ok && holds(file, file.record_pos(i), i);
+    check(ok, "replay: untouched and rewritten records");
+    check(holds(file, file.record_pos(47), 3000), "replay: record appended after truncate");
+}
+
+}  // namespace
+
+int main() {
+    char dir[] = "/tmp/journal_test.XXXXXX";
+    if (::mkdtemp(dir) == nullptr || ::chdir(dir) != 0) {
+        std::printf("cannot create a scratch directory\n");
+        return 1;
+    }
+    test_journal_replay();
+    if (::chdir("/") == 0) std::system((std::string("rm -rf ") + dir).c_str());
+    if (failures == 0) std::printf("journal: ok\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#pragma once
+// log 指令的查询用例：按 log 指令的定义从全部记录算出期望的筛选结果，与程序的输出比较。
+#include "bookstore_harness.h"
+
+#include <algorithm>
+
+namespace {
+
+struct LogQuery {
+    std::string args;
+    std::string user, type;
+    int from, to, last;
+};
+
+inline LogQuery query(const std::string &args, const std::string &user = "", const std::string &type = "",
+                      int from = 1, int to = 0x7fffffff, int last = -1) {
+    LogQuery q = {args, user, type, from, to, last};
+    return q;
+}
+
+// 按 log 指令的定义，从全部记录中算出筛选结果
+inline std::string expect_log(const std::vector<std::string> &lines, const LogQuery &q) {
+    int total = static_cast<int>(lines.size());
+    if (q.last > total) return "Invalid\n";
+    int lo = q.last >= 0 ? total - q.last : q.from - 1;
+    int hi = q.last >= 0 ? total - 1 : std::min(q.to, total) - 1;
+    std::string s = "LOG\n";
+    for (int i = lo; i <= hi; ++i) {
+        std::istringstream fields(lines[i]);
+        std::string user, type;
+        fields >> user >> type;
+        if ((q.user.empty() || user == q.user) && (q.type.empty() || type == q.type)) s += lines[i] + "\n";
+    }
+    return s + "END\n";
+}
+
+// 取出一次 log 输出中的记录；输出不是 LOG ... END 的形式时返回空
+inline std::vector<std::string> parse_log(const std::string &out) {
+    std::vector<std::string> lines;
+    std::istringstream in(out);
+    std::string line;
+    if (!std::getline(in, line) || line != "LOG") return lines;
+    while (std::getline(in, line) && line != "END") lines.push_back(line);
+    return lines;
+}
+
+// 在 dir 中先取全部日志，再逐条执行 queries，与按全部日志算出的结果比较。
+// user 为 "!" 的查询应输出 Invalid
+inline void check_log_queries(const std::string &dir, const std::vector<LogQuery> &queries, const std::string &what) {
+    std::vector<std::string> lines = parse_log(run(dir, "su root sjtu\nlog\nexit\n"));
+    check(!lines.empty(), what + ": full log");
+    // 查询前的 su 又追加了一条记录
+    lines.push_back("root SYS su root sjtu");
+    std::string input = "su root sjtu\n", expect;
+    for (const LogQuery &q : queries) {
+        input += "log" + (q.args.empty() ? "" : " " + q.args) + "\n";
+        expect += q.user == "!" ? "Invalid\n" : expect_log(lines, q);
+    }
+    check(run(dir, input + "exit\n") == expect, what + ": filtered results");
+}
+
+inline LogQuery invalid(const std::string &args) {
+    return query(args, "!");
+}
+
+}  // namespace
@@ -0,0 +1,67 @@
+// log 指令的筛选：按用户、类型、范围和最近若干条的各种组合，以及非法的参数组合。
+#include "log_queries.h"
+
+namespace {
+
+void test_log_filters() {
+    std::string dir = fresh_dir("log");
+    std::string script =
+        "su root sjtu\n"
+        "useradd alice apw 3 Alice\n"
+        "useradd bob bpw 3 Bob\n"
+        "select L-1\n"
+        "modify -name=\"Log One\" -price=10\n"
+        "import 10 50\n";
+    for (int round = 0; round < 4; ++round) {
+        script +=
+            "su alice apw\n"
+            "select L-2\n"
+            "modify -name=\"Log Two\" -keyword=\"x|y\" -price=3.5\n"
+            "import 20 30\n"
+            "buy L-1 2\n"
+            "log\n"
+            "logout\n"
+            "su bob bpw\n"
+            "buy L-2 3\n"
+            "show -name=\"Log One\"\n"
+            "buy L-1 1\n"
+            "logout\n"
+            "show finance\n";
+    }
+    std::string out = run(dir, script + "exit\n");
+    check(out.find("Invalid\n") != std::string::npos, "log: refused below privilege 7");
+
+    std::vector<LogQuery> queries;
+    queries.push_back(query(""));
+    queries.push_back(query("-user=alice", "alice"));
+    queries.push_back(query("-user=bob", "bob"));
+    queries.push_back(query("-user=nobody", "nobody"));
+    queries.push_back(query("-type=FIN", "", "FIN"));
+    queries.push_back(query("-type=SYS", "", "SYS"));
+    queries.push_back(query("-user=alice -type=FIN", "alice", "FIN"));
+    queries.push_back(query("-type=SYS -user=bob -from=3 -to=20", "bob", "SYS", 3, 20));
+    queries.push_back(query("-from=5 -to=9", "", "", 5, 9));
+    queries.push_back(query("-from=9 -to=5", "", "", 9, 5));
+    queries.push_back(query("-from=30", "", "", 30));
+    queries.push_back(query("-to=4", "", "", 1, 4));
+    queries.push_back(query("-from=1000", "", "", 1000));
+    queries.push_back(query("-last=0", "", "", 1, 0x7fffffff, 0));
+    queries.push_back(query("-last=7", "", "", 1, 0x7fffffff, 7));
+    queries.push_back(query("-user=root -last=10", "root", "", 1, 0x7fffffff, 10));
+    queries.push_back(query("-type=FIN -last=5", "", "FIN", 1, 0x7fffffff, 5));
+    queries.push_back(query("-last=1000", "", "", 1, 0x7fffffff, 1000));
+    queries.push_back(invalid("-last=3 -from=1"));
+    queries.push_back(invalid("-user=alice -user=bob"));
+    queries.push_back(invalid("-type=BAD"));
+    queries.push_back(invalid("-from=0"));
+    queries.push_back(invalid("-to=x"));
+    queries.push_back(invalid("-level=1"));
+    queries.push_back(invalid("-user="));
+    check_log_queries(dir, queries, "log");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    return harness_main(argc, argv, "log_query", test_log_filters);
+}
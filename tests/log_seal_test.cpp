@@ -0,0 +1,55 @@
+// 日志归档分段：分两次运行各写入 7000 余条记录，每次都跨过一个归档段的边界；
+// 归档后全部日志和跨段的筛选结果不变，log.dat 只留下不足一段的记录。
+#include "log_queries.h"
+
+namespace {
+
+// 每条 show 指令产生一条 SYS 记录；每隔 1000 条插入一次进货，另有一条 FIN 记录
+void append_log_workload(std::vector<std::string> &expected, std::string &input, int first, int count) {
+    char buf[64];
+    for (int i = first; i < first + count; ++i) {
+        if (i % 1000 == 0) {
+            input += "import 1 1\n";
+            expected.push_back("root FIN IMPORT qty=1 cost=1.00");
+            expected.push_back("root SYS import 1 1");
+        }
+        std::snprintf(buf, sizeof(buf), "show -ISBN=S%05d", i);
+        input += std::string(buf) + "\n";
+        expected.push_back(std::string("root SYS ") + buf);
+    }
+}
+
+void test_segment_sealing() {
+    std::string dir = fresh_dir("seal");
+    std::vector<std::string> expected;
+    // 分两次运行，每次都跨过一个归档段的边界（一段 6144 条）
+    for (int part = 0; part < 2; ++part) {
+        std::string input = "su root sjtu\nselect SEAL-1\n";
+        expected.push_back("root SYS su root sjtu");
+        expected.push_back("root SYS select SEAL-1");
+        append_log_workload(expected, input, part * 7000, 7000);
+        run(dir, input + "exit\n");
+
+        std::vector<std::string> lines = parse_log(run(dir, "su root sjtu\nlog\nexit\n"));
+        expected.push_back("root SYS su root sjtu");
+        check(lines == expected, "seal: full log after part " + std::to_string(part));
+    }
+    // 归档后 log.dat 只留不足一段的记录
+    check(file_size(dir + "/log.dat") < (1L << 20), "seal: log.dat keeps less than one segment");
+    check(file_size(dir + "/log.seg") > 0, "seal: sealed segments written");
+
+    std::vector<LogQuery> queries;
+    queries.push_back(query("-from=6100 -to=6200", "", "", 6100, 6200));
+    queries.push_back(query("-from=12280 -to=12300", "", "", 12280, 12300));
+    queries.push_back(query("-last=1000", "", "", 1, 0x7fffffff, 1000));
+    queries.push_back(query("-type=FIN", "", "FIN"));
+    queries.push_back(query("-user=root -type=SYS -from=6000 -to=6300", "root", "SYS", 6000, 6300));
+    check_log_queries(dir, queries, "seal");
+    check(file_count(dir) <= 20, "seal: at most 20 runtime files");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    return harness_main(argc, argv, "log_seal", test_segment_sealing);
+}
@@ -0,0 +1,93 @@
+// lz_codec 的回归测试：各种数据的压缩往返，以及截断、长度不符、损坏的输入不会越界。
+#include "include/lz_codec.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what, size_t n) {
+    if (ok) return;
+    ++failures;
+    if (failures <= 10) std::printf("FAIL %s n=%zu\n", what, n);
+}
+
+void round_trip(const std::string &raw, const char *what) {
+    std::string packed, back;
+    lz_compress(raw.data(), raw.size(), packed);
+    check(lz_decompress(packed.data(), packed.size(), raw.size(), back) && back == raw, what, raw.size());
+}
+
+// 形如日志的数据：少量不同的行反复出现，夹杂序号
+std::string log_like(std::mt19937 &rng, size_t n) {
+    static const char *lines[] = {"root SYS select ", "alice FIN BUY isbn=", "bob SYS modify -name=\"", "root SYS show\n"};
+    std::string s;
+    while (s.size() < n) {
+        s += lines[rng() % 4];
+        s += std::to_string(rng() % 1000);
+        s += '\n';
+    }
+    s.resize(n);
+    return s;
+}
+
+void test_round_trips(std::mt19937 &rng) {
+    for (size_t n = 0; n <= 64; ++n) {
+        std::string random(n, '\0'), runs(n, 'a');
+        for (char &c : random) c = static_cast<char>(rng());
+        round_trip(random, "random bytes");
+        round_trip(runs, "single byte run");
+    }
+    // 长字面量与长匹配都要用到扩展长度；重叠匹配（距离 1）逐字节复制
+    std::string zeros(200000, '\0');
+    round_trip(zeros, "long zero run");
+    std::string noise(100000, '\0');
+    for (char &c : noise) c = static_cast<char>(rng());
+    round_trip(noise, "incompressible");
+    round_trip(log_like(rng, 300000), "log-like");
+    // 重复内容相距超过 65535 字节，不能用作匹配
+    std::string far = noise.substr(0, 70000) + noise.substr(0, 70000);
+    round_trip(far, "repeat beyond the window");
+
+    std::string packed;
+    lz_compress(zeros.data(), zeros.size(), packed);
+    check(packed.size() < zeros.size() / 100, "zero run compresses", zeros.size());
+    std::string text = log_like(rng, 300000);
+    lz_compress(text.data(), text.size(), packed);
+    check(packed.size() < text.size() / 2, "log-like compresses", text.size());
+}
+
+void test_bad_input(std::mt19937 &rng) {
+    std::string raw = log_like(rng, 5000), packed, out;
+    lz_compress(raw.data(), raw.size(), packed);
+
+    check(!lz_decompress(packed.data(), packed.size(), raw.size() - 1, out), "raw_len too small", raw.size());
+    check(!lz_decompress(packed.data(), packed.size(), raw.size() + 1, out), "raw_len too large", raw.size());
+
+    // 截断的输入：或者报错，或者（恰好在序列边界截断时）给出正确的内容
+    for (size_t cut = 0; cut < packed.size(); ++cut) {
+        bool ok = lz_decompress(packed.data(), cut, raw.size(), out);
+        check(!ok || out == raw, "truncated input", cut);
+    }
+    // 随机改动若干字节：只要求不越界，成功时长度正确
+    for (int round = 0; round < 2000; ++round) {
+        std::string bad = packed;
+        int flips = 1 + static_cast<int>(rng() % 4);
+        for (int k = 0; k < flips; ++k) bad[rng() % bad.size()] = static_cast<char>(rng());
+        bool ok = lz_decompress(bad.data(), bad.size(), raw.size(), out);
+        check(!ok || out.size() == raw.size(), "corrupted input", bad.size());
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(20251017);
+    test_round_trips(rng);
+    test_bad_input(rng);
+    std::printf("lz_codec: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// MemoryRiver 的回归测试：空闲槽位复用与在线压缩。
+#include "include/MemoryRiver.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (ok) return;
+    ++failures;
+    std::printf("FAIL %s\n", what);
+}
+
+// 空闲链表的后继存放在槽位的最后一个 int 中
+struct Rec {
+    int key;
+    int payload[14];
+    int reserved;
+};
+
+Rec make(int key) {
+    Rec r;
+    r.key = key;
+    for (int i = 0; i < 14; ++i) r.payload[i] = key * 31 + i;
+    r.reserved = 0;
+    return r;
+}
+
+bool holds(MemoryRiver<Rec, 2, 2> &file, int pos, int key) {
+    Rec r;
+    file.read(r, pos);
+    return r.key == key && r.payload[13] == key * 31 + 13;
+}
+
+long file_size(const char *name) {
+    struct stat st;
+    return ::stat(name, &st) == 0 ? static_cast<long>(st.st_size) : -1;
+}
+
+void test_free_slots() {
+    MemoryRiver<Rec, 2, 2> file("slots.dat");
+    file.initialise();
+    std::vector<int> pos;
+    for (int i = 0; i < 10; ++i) {
+        Rec r = make(i);
+        pos.push_back(file.write(r));
+    }
+    file.Delete(pos[3]);
+    file.Delete(pos[7]);
+    check(file.free_count() == 2, "free_slots: free_count after Delete");
+
+    // 新对象依次落进最近释放的槽位，文件不变长
+    Rec a = make(100), b = make(101);
+    int pa = file.write(a), pb = file.write(b);
+    check(pa == pos[7] && pb == pos[3], "free_slots: write reuses freed slots");
+    check(file.slot_count() == 10, "free_slots: slot_count unchanged");
+    check(file.free_count() == 0, "free_slots: free list drained");
+    Rec c = make(102);
+    check(file.write(c) == file.record_pos(10), "free_slots: append once the free list is empty");
+    check(holds(file, pos[7], 100) && holds(file, pos[3], 101) && holds(file, pos[0], 0),
+          "free_slots: contents");
+}
+
+void test_compact() {
+    std::map<int, int> where;  // key -> 位置
+    {
+        MemoryRiver<Rec, 2, 2> file("compact.dat");
+        file.initialise();
+        std::vector<int> pos;
+        for (int i = 0; i < 40; ++i) {
+            Rec r = make(i);
+            pos.push_back(file.write(r));
+        }
+        for (int i = 0; i < 40; ++i) {
+            if (i % 3 == 0 || i >= 30) file.Delete(pos[i]);
+            else where[i] = pos[i];
+        }
+        std::map<int, int> key_at;
+        for (const auto &kv : where) key_at[kv.second] = kv.first;
+        int moves = 0;
+        int live = file.compact([&](int from, int to) {
+            ++moves;
+            where[key_at[from]] = to;
+        });
+        check(live == static_cast<int>(where.size()), "compact: live count");
+        check(moves > 0, "compact: moved records into holes");
+        check(file.slot_count() == live && file.free_count() == 0, "compact: file truncated, free list empty");
+    }
+    // 重新打开，检查压缩结果已写回文件
+    MemoryRiver<Rec, 2, 2> file("compact.dat");
+    bool ok = true;
+    for (const auto &kv : where) ok = ok && holds(file, kv.second, kv.first);
+    check(ok, "compact: records readable at their new positions after reopen");
+    check(file_size("compact.dat") == file.record_pos(static_cast<int>(where.size())), "compact: file length");
+}
+
+}  // namespace
+
+int main() {
+    char dir[] = "/tmp/memory_river_test.XXXXXX";
+    if (::mkdtemp(dir) == nullptr || ::chdir(dir) != 0) {
+        std::printf("cannot create a scratch directory\n");
+        return 1;
+    }
+    test_free_slots();
+    test_compact();
+    if (::chdir("/") == 0) std::system((std::string("rm -rf ") + dir).c_str());
+    if (failures == 0) std::printf("memory_river: ok\n");
+    return failures == 0 ? 0 : 1;
+}
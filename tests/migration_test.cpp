@@ -0,0 +1,124 @@
+// 旧版数据迁移：在空目录中写入旧版定长格式的 users.dat / books.dat / finance.dat，
+// 启动后账户、书目和账目都应原样可查，旧版的删除标记成为可复用的空闲槽位，再次启动不会重复迁移。
+#include "bookstore_harness.h"
+
+namespace {
+
+// 旧版的定长记录，与当时的 user.h / book.h / finance.cpp 一致
+struct LegacyUser {
+    char user_id[31];
+    char password[31];
+    char username[31];
+    int privilege;
+};
+
+struct LegacyBook {
+    char isbn[21];
+    char name[61];
+    char author[61];
+    char keywords[61];
+    double price;
+    int quantity;
+};
+
+struct LegacyFinanceRecord {
+    bool is_income;
+    double amount;
+};
+
+LegacyUser legacy_user(const char *id, const char *password, const char *name, int privilege) {
+    LegacyUser u;
+    std::memset(&u, 0, sizeof(u));
+    std::strcpy(u.user_id, id);
+    std::strcpy(u.password, password);
+    std::strcpy(u.username, name);
+    u.privilege = privilege;
+    return u;
+}
+
+LegacyBook legacy_book(const char *isbn, const char *name, const char *author, const char *keywords,
+                       double price, int quantity) {
+    LegacyBook b;
+    std::memset(&b, 0, sizeof(b));
+    std::strcpy(b.isbn, isbn);
+    std::strcpy(b.name, name);
+    std::strcpy(b.author, author);
+    std::strcpy(b.keywords, keywords);
+    b.price = price;
+    b.quantity = quantity;
+    return b;
+}
+
+template<class T>
+void write_legacy(const std::string &path, const int *header, int header_ints, const std::vector<T> &records) {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out.write(reinterpret_cast<const char *>(header), header_ints * sizeof(int));
+    out.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(T));
+}
+
+void test_legacy_migration() {
+    std::string dir = fresh_dir("legacy");
+
+    // 第二个槽位是旧版的删除标记（全零）
+    std::vector<LegacyUser> users;
+    users.push_back(legacy_user("root", "sjtu", "Super Admin", 7));
+    users.push_back(LegacyUser());
+    std::memset(&users.back(), 0, sizeof(LegacyUser));
+    users.push_back(legacy_user("alice", "apw", "Alice", 3));
+    int user_header[1] = {3};
+    write_legacy(dir + "/users.dat", user_header, 1, users);
+
+    std::vector<LegacyBook> books;
+    books.push_back(legacy_book("978-0", "Old Book", "Old Author", "old|legacy", 19.99, 7));
+    books.push_back(legacy_book("978-9", "Second", "", "", 5.5, 0));
+    int book_header[1] = {2};
+    write_legacy(dir + "/books.dat", book_header, 1, books);
+
+    std::vector<LegacyFinanceRecord> finance(3);
+    std::memset(static_cast<void *>(finance.data()), 0, finance.size() * sizeof(LegacyFinanceRecord));
+    finance[0].is_income = true;
+    finance[0].amount = 10.0;
+    finance[1].is_income = false;
+    finance[1].amount = 3.5;
+    finance[2].is_income = true;
+    finance[2].amount = 2.25;
+    int finance_header[3] = {1225, 350, 3};
+    write_legacy(dir + "/finance.dat", finance_header, 3, finance);
+
+    const std::string queries =
+        "su alice apw\n"
+        "show\n"
+        "show -keyword=\"legacy\"\n"
+        "show -author=\"Old Author\"\n"
+        "show -ISBN=978-9\n"
+        "su root sjtu\n"
+        "show finance\n"
+        "show finance 1\n"
+        "show finance 2\n"
+        "exit\n";
+    const std::string expect =
+        "978-0\tOld Book\tOld Author\told|legacy\t19.99\t7\n"
+        "978-9\tSecond\t\t\t5.50\t0\n"
+        "978-0\tOld Book\tOld Author\told|legacy\t19.99\t7\n"
+        "978-0\tOld Book\tOld Author\told|legacy\t19.99\t7\n"
+        "978-9\tSecond\t\t\t5.50\t0\n"
+        "+ 12.25 - 3.50\n"
+        "+ 2.25 - 0.00\n"
+        "+ 2.25 - 3.50\n";
+    check(run(dir, queries) == expect, "legacy: migrated users, books and finance");
+
+    // 旧版的删除标记转成了空闲槽位，新账户复用它，文件不变长
+    long users_size = file_size(dir + "/users.dat");
+    check(run(dir, "su root sjtu\nuseradd carol cpw 1 Carol\nsu carol cpw\nexit\n").empty(), "legacy: add a user");
+    check(file_size(dir + "/users.dat") == users_size, "legacy: deleted slot reused");
+
+    // 再次启动不会重复迁移
+    check(run(dir, queries) == expect, "legacy: second start keeps the migrated data");
+    check(file_count(dir) <= 20, "legacy: at most 20 runtime files");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    return harness_main(argc, argv, "migration", test_legacy_migration);
+}
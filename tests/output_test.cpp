@@ -0,0 +1,72 @@
+// Output 的回归测试：Fixed2 与 printf("%.2f") 逐字相同，包括走 snprintf 退路的超大数和非有限值；
+// 整数的最小值、最大值。标准输出重定向到临时文件后读回比较。
+#include "include/output.h"
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+void expect_fixed2(std::string &expect, double v) {
+    char text[400];
+    std::snprintf(text, sizeof(text), "%.2f\n", v);
+    expect += text;
+    output() << Fixed2(v) << '\n';
+}
+
+}  // namespace
+
+int main() {
+    char path[] = "/tmp/output_test.XXXXXX";
+    int fd = ::mkstemp(path);
+    int saved = ::dup(1);
+    if (fd < 0 || saved < 0 || ::dup2(fd, 1) < 0) {
+        std::printf("cannot redirect standard output\n");
+        return 1;
+    }
+
+    std::string expect;
+    const double edges[] = {0.0, -0.0, 0.005, 0.015, 0.125, 2.675, -2.675, 1e15, 90071992547409.92,
+                            1e16, -1e16, 1e300, -1e300, DBL_MAX, -DBL_MAX, DBL_MIN, HUGE_VAL, -HUGE_VAL, NAN};
+    for (double v : edges) expect_fixed2(expect, v);
+    std::mt19937_64 rng(18);
+    for (int i = 0; i < 20000; ++i) {
+        // 价格范围内的两位小数、任意比特的 double
+        expect_fixed2(expect, static_cast<double>(rng() % 100000000) / 100);
+        double bits_value;
+        unsigned long long bits = rng();
+        std::memcpy(&bits_value, &bits, sizeof(bits_value));
+        expect_fixed2(expect, bits_value);
+    }
+    output() << LLONG_MIN << ' ' << LLONG_MAX << ' ' << INT_MIN << '\n';
+    expect += std::to_string(LLONG_MIN) + " " + std::to_string(LLONG_MAX) + " " + std::to_string(INT_MIN) + "\n";
+    output().flush();
+
+    ::dup2(saved, 1);
+    std::ifstream fin(path, std::ios::binary);
+    std::stringstream got;
+    got << fin.rdbuf();
+    ::unlink(path);
+
+    bool ok = got.str() == expect;
+    if (!ok) {
+        size_t i = 0;
+        while (i < expect.size() && i < got.str().size() && expect[i] == got.str()[i]) ++i;
+        size_t line = expect.rfind('\n', i);
+        line = line == std::string::npos ? 0 : line + 1;
+        std::printf("FAIL first difference: expected \"%s\"\n", expect.substr(line, expect.find('\n', line) - line).c_str());
+    }
+    std::printf("output: %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
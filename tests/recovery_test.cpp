@@ -0,0 +1,86 @@
+// 被 kill -9 后重启的恢复：交互地执行一串修改书目和账目的指令，在某条指令处理到一半时杀掉进程，
+// 重启后的状态必须等于从空目录执行完之前（或包括这一条）指令的状态。
+#include "bookstore_harness.h"
+
+#include <random>
+
+namespace {
+
+std::vector<std::string> book_workload(std::mt19937 &rng, int groups) {
+    std::vector<std::string> cmds;
+    cmds.push_back("su root sjtu");
+    char buf[200];
+    for (int i = 0; i < groups; ++i) {
+        std::snprintf(buf, sizeof(buf), "K%04d", static_cast<int>(rng() % 300));
+        std::string isbn = buf;
+        cmds.push_back("select " + isbn);
+        std::snprintf(buf, sizeof(buf), "modify -name=\"N%d\" -author=\"A%d\" -keyword=\"k%d|q%d\" -price=%d.5",
+                      static_cast<int>(rng() % 200), static_cast<int>(rng() % 60),
+                      static_cast<int>(rng() % 30), static_cast<int>(rng() % 30), static_cast<int>(rng() % 99));
+        cmds.push_back(buf);
+        std::snprintf(buf, sizeof(buf), "import %d %d.00", static_cast<int>(rng() % 8 + 1), static_cast<int>(rng() % 90 + 1));
+        cmds.push_back(buf);
+        if (i % 3 == 0) cmds.push_back("buy " + isbn + " 1");
+    }
+    return cmds;
+}
+
+std::string state_queries() {
+    std::string q = "su root sjtu\nshow\n";
+    for (int k = 0; k < 30; k += 4) q += "show -keyword=\"k" + std::to_string(k) + "\"\n";
+    for (int k = 0; k < 200; k += 23) q += "show -name=\"N" + std::to_string(k) + "\"\n";
+    for (int k = 0; k < 60; k += 11) q += "show -author=\"A" + std::to_string(k) + "\"\n";
+    return q + "show finance\nshow finance 7\nexit\n";
+}
+
+// 从空目录执行前 k 条指令后的状态
+std::string reference_state(const std::vector<std::string> &cmds, size_t k) {
+    std::string dir = fresh_dir("reference");
+    run(dir, join(cmds, 0, k) + "exit\n");
+    return run(dir, state_queries());
+}
+
+void test_kill_recovery() {
+    std::mt19937 rng(5);
+    std::vector<std::string> cmds = book_workload(rng, 500);
+    std::string dir = fresh_dir("kill");
+    size_t done = 0;
+    for (int life = 0; life < 6 && done + 1 < cmds.size(); ++life) {
+        size_t target = done + 40 + rng() % 200;
+        if (target >= cmds.size()) target = cmds.size() - 1;
+        Live live = start(dir);
+        // 重启后重新登录并选中图书，不改变书目和账目
+        if (done > 0) {
+            send_acked(live, "su root sjtu");
+            for (size_t i = done; i-- > 0;) {
+                if (cmds[i].compare(0, 7, "select ") == 0) {
+                    send_acked(live, cmds[i]);
+                    break;
+                }
+            }
+        }
+        bool ok = true;
+        for (; done < target && ok; ++done) ok = send_acked(live, cmds[done]);
+        check(ok, "kill: child answered every command");
+        // 最后一条指令处理到一半时杀掉
+        send(live, cmds[done]);
+        ::usleep(static_cast<useconds_t>(rng() % 3000));
+        kill_live(live);
+
+        std::string got = run(dir, state_queries());
+        if (got == reference_state(cmds, done + 1)) {
+            ++done;
+        } else if (got != reference_state(cmds, done)) {
+            check(false, "kill: state after restart matches a prefix, life " + std::to_string(life));
+            break;
+        }
+    }
+    check(file_count(dir) <= 20, "kill: at most 20 runtime files");
+}
+
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    return harness_main(argc, argv, "recovery", test_kill_recovery);
+}
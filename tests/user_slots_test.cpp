@@ -0,0 +1,41 @@
+// users.dat 的空闲槽位：删除的账户槽位由之后注册的账户复用，
+// 空出超过一半后压缩文件，被搬动的账户仍能登录。
+#include "bookstore_harness.h"
+
+namespace {
+
+void test_user_slots() {
+    std::string dir = fresh_dir("users");
+    std::string input = "su root sjtu\n";
+    for (int i = 0; i < 100; ++i) input += "useradd u" + std::to_string(i) + " pw 1 U\n";
+    run(dir, input + "exit\n");
+    long full = file_size(dir + "/users.dat");
+    check(full > 0, "users: users.dat created");
+
+    // 删除后再注册，复用空出的槽位
+    run(dir, "su root sjtu\ndelete u5\nuseradd v5 pw 1 V\nexit\n");
+    check(file_size(dir + "/users.dat") == full, "users: freed slot reused");
+
+    // 超过一半的槽位空出后压缩，文件变短
+    input = "su root sjtu\n";
+    for (int i = 10; i < 90; ++i) input += "delete u" + std::to_string(i) + "\n";
+    run(dir, input + "exit\n");
+    check(file_size(dir + "/users.dat") < full / 2, "users: compacted after mass delete");
+
+    // 压缩搬动过的账户仍能登录，删除的不能
+    std::string expect;
+    input.clear();
+    for (int i = 0; i < 100; ++i) {
+        if (i == 5) continue;
+        input += "su u" + std::to_string(i) + " pw\nlogout\n";
+        if (i >= 10 && i < 90) expect += "Invalid\nInvalid\n";
+    }
+    input += "su v5 pw\nlogout\n";
+    check(run(dir, input + "exit\n") == expect, "users: logins after compaction");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    return harness_main(argc, argv, "user_slots", test_user_slots);
+}